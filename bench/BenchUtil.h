@@ -0,0 +1,136 @@
+#pragma once
+// Small helpers shared by the benchmark executables in bench/.
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "GLExt.h"
+#include "GLState.h"
+#include "JsonString.h"
+#include "Offscreen.h"
+#include "Paths.h"
+#include "RenderStats.h"
+#include "RoomRenderer.h"
+
+// hidden 3.3 core window, just to own a GL context; extensions loaded and
+// depth testing on, the way the renderer starts
+inline GLFWwindow* createBenchContext(int w = 1280, int h = 720) {
+    if (!glfwInit()) { std::cerr << "GLFW init failed\n"; return nullptr; }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(w, h, "bench", nullptr, nullptr);
+    if (!window) { std::cerr << "GLFW create window failed\n"; glfwTerminate(); return nullptr; }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        std::cerr << "GLAD init failed\n"; glfwTerminate(); return nullptr;
+    }
+    GLExt::load((GLADloadproc)glfwGetProcAddress);
+    glState().enable(GL_DEPTH_TEST, true);
+    return window;
+}
+
+struct BenchTimer {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    double ms() const {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+// mean / percentiles of one metric over the measured frames
+struct Summary {
+    double mean = 0, p50 = 0, p90 = 0, p99 = 0, min = 0, max = 0;
+};
+
+inline Summary summarize(std::vector<double> v) {
+    Summary s;
+    if (v.empty()) return s;
+    std::sort(v.begin(), v.end());
+    auto pct = [&](double p) { return v[std::min(v.size() - 1, (size_t)(p * (v.size() - 1) + 0.5))]; };
+    double sum = 0;
+    for (double x : v) sum += x;
+    s.mean = sum / v.size();
+    s.p50 = pct(0.50);
+    s.p90 = pct(0.90);
+    s.p99 = pct(0.99);
+    s.min = v.front();
+    s.max = v.back();
+    return s;
+}
+
+inline void writeSummaryJson(std::ostream& o, const char* name, const Summary& s, bool last = false) {
+    o << "    \"" << name << "\": { \"mean\": " << s.mean << ", \"p50\": " << s.p50
+      << ", \"p90\": " << s.p90 << ", \"p99\": " << s.p99
+      << ", \"min\": " << s.min << ", \"max\": " << s.max << " }" << (last ? "\n" : ",\n");
+}
+
+// The frame loop of the GPU benches: an offscreen target the size of the
+// window and one GL_TIME_ELAPSED query. run() calls frame(measured) for
+// kWarmup frames and then `frames` more with stats reset and the target
+// bound; frame brackets the part it wants timed with begin() / end(). The
+// result is read back at once (a stall, so CPU timing belongs inside
+// frame) and the measured frames' GPU ms are returned. Destroy before
+// glfwTerminate.
+class GpuFrameBench {
+public:
+    static const int kWarmup = 5;
+
+    OffscreenTarget target;
+
+    GpuFrameBench(int width, int height) : target(width, height) { glGenQueries(1, &query); }
+    ~GpuFrameBench() { glDeleteQueries(1, &query); }
+    GpuFrameBench(const GpuFrameBench&) = delete;
+    GpuFrameBench& operator=(const GpuFrameBench&) = delete;
+
+    void begin() { glBeginQuery(GL_TIME_ELAPSED, query); }
+    void end() { glEndQuery(GL_TIME_ELAPSED); }
+
+    template <class Frame>
+    std::vector<double> run(int frames, Frame&& frame) {
+        std::vector<double> gpu;
+        for (int f = 0; f < frames + kWarmup; ++f) {
+            renderStats().reset();
+            target.bind();
+            frame(f >= kWarmup);
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &ns);
+            if (f >= kWarmup) gpu.push_back(ns / 1.0e6);
+        }
+        return gpu;
+    }
+
+private:
+    GLuint query = 0;
+};
+
+// loadScene or exit, the benches have nothing to measure without it; the
+// material textures are all in before the first frame
+inline void loadBenchScene(RoomRenderer& renderer, const std::string& path) {
+    std::string err;
+    if (!renderer.loadScene(path, err)) { std::cerr << "Scene load failed: " << err << "\n"; std::exit(1); }
+    renderer.textures.finish();
+}
+
+// the scene's first room, or a 10 x 4 x 14 m one at the origin for a scene
+// with none, so generated furniture has somewhere to go
+inline RoomDesc benchRoom(const SceneDesc& scene) {
+    return scene.rooms.empty()
+        ? RoomDesc{ glm::vec3(0.0f), glm::vec3(10.0f, 4.0f, 14.0f), {}, {}, {}, {}, {}, 0, 0 }
+        : scene.rooms[0];
+}
+
+// a piece added after loadScene, to the description and the baked scene alike
+inline void addBenchFurniture(RoomRenderer& renderer, const FurnitureDesc& f, const char* label) {
+    renderer.sceneDesc.furniture.push_back(f);
+    renderer.scene.add([f](const FurnitureContext& c) { emitFurniture(c, f); }, label);
+}
@@ -0,0 +1,128 @@
+// Culling cost and yield on growing apartment grids (CPU only, no GL
+// context): every box tested with the scalar plane test, every box with the
+// SSE test, the BVH walk, and portal/cell visibility. Cameras are random
+// poses inside the grid; "visible" is the share of boxes each method keeps.
+//
+// usage: cull_bench [cameras=512]
+
+#include "BakedScene.h"
+#include "BenchUtil.h"
+#include "BoxBvh.h"
+#include "CameraPath.h"
+#include "Frustum.h"
+#include "PortalCuller.h"
+#include "SceneFile.h"
+#include "Furniture.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+// gx * gz copies of the living room, 10 x 14 units each, with a doorway
+// between every pair of neighbours (like scenes/apartment.scene)
+static SceneDesc buildGrid(int gx, int gz) {
+    SceneDesc desc;
+    const glm::vec3 floorCol = hexRGB(0x6B8E23), ceilCol = hexRGB(0xE0E0E0);
+    const glm::vec3 wallCol = hexRGB(0xC0D6FF), sideCol = hexRGB(0xADD8E6);
+    auto furniture = [&](FurnitureType type, glm::vec3 pos, float yaw, glm::vec3 scale, glm::vec3 color) {
+        desc.furniture.push_back(FurnitureDesc{ type, pos, yaw, scale, color, 0, 0 });
+    };
+    for (int j = 0; j < gz; ++j) {
+        for (int i = 0; i < gx; ++i) {
+            glm::vec3 c(i * 10.0f, 0.0f, -j * 14.0f);
+            uint32_t r = (uint32_t)desc.rooms.size();
+            desc.rooms.push_back(RoomDesc{ c, { 10.0f, 4.0f, 14.0f }, floorCol, ceilCol, wallCol, wallCol, sideCol, 0, 0 });
+            if (i + 1 < gx)
+                desc.portals.push_back(PortalDesc{ r, r + 1, c + glm::vec3(5.0f, 0.0f, 3.0f), c + glm::vec3(5.0f, 2.2f, 4.2f) });
+            if (j + 1 < gz)
+                desc.portals.push_back(PortalDesc{ r, r + (uint32_t)gx, c + glm::vec3(-3.5f, 0.0f, -7.0f), c + glm::vec3(-2.3f, 2.2f, -7.0f) });
+
+            furniture(FurnitureType::CoffeeTable, c + glm::vec3(0.8f, 0.0f, -1.2f), 0.0f, glm::vec3(1.0f), glm::vec3(0.0f));
+            furniture(FurnitureType::TVStand, c + glm::vec3(0.0f, 0.5f, -4.7f), 0.0f, glm::vec3(1.0f), glm::vec3(0.0f));
+            furniture(FurnitureType::Sofa, c + glm::vec3(3.0f, 0.0f, -1.2f), 270.0f, glm::vec3(1.0f), glm::vec3(0.0f));
+            furniture(FurnitureType::Box, c + glm::vec3(0.0f, 3.0f, 2.5f), 0.0f, glm::vec3(0.12f), hexRGB(0xFFF2B2));
+        }
+    }
+    return desc;
+}
+
+int main(int argc, char** argv) {
+    int cameras = argc > 1 ? std::atoi(argv[1]) : 512;
+    const glm::mat4 proj = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+
+    std::printf("%8s %8s %10s %12s %12s %12s %9s %12s %9s %7s\n",
+        "rooms", "boxes", "build ms", "scalar us", "sse us", "bvh us", "visible", "portal us", "visible", "cells");
+    const int grids[][2] = { { 1, 1 }, { 4, 3 }, { 8, 8 }, { 16, 16 }, { 32, 32 } };
+    for (const auto& g : grids) {
+        SceneDesc desc = buildGrid(g[0], g[1]);
+        BakedScene scene;  // never attached: CPU only
+        populateScene(scene, desc);
+        scene.bake();
+        const BoxBatch& boxes = scene.boxes;
+        const size_t n = boxes.size();
+
+        std::vector<Aabb> aabbs(n);
+        for (size_t i = 0; i < n; ++i) aabbs[i] = boxAabb(boxes.models[i]);
+
+        BenchTimer tBuild;
+        BoxBvh bvh;
+        bvh.build(boxes.models.data(), n);
+        double buildMs = tBuild.ms();
+
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<float> x(-4.5f, g[0] * 10.0f - 5.5f), z(-(g[1] - 1) * 14.0f - 6.5f, 6.5f);
+        std::uniform_real_distribution<float> yaw(0.0f, 360.0f), pitch(-20.0f, 20.0f);
+        std::vector<glm::vec3> eyes;
+        std::vector<glm::mat4> viewProjs;
+        std::vector<Frustum> frusta;
+        for (int c = 0; c < cameras; ++c) {
+            glm::vec3 pos(x(rng), 1.5f, z(rng));
+            glm::vec3 front = frontFromYawPitch(yaw(rng), pitch(rng));
+            eyes.push_back(pos);
+            viewProjs.push_back(proj * glm::lookAt(pos, pos + front, glm::vec3(0, 1, 0)));
+            frusta.push_back(Frustum::fromMatrix(viewProjs.back()));
+        }
+
+        size_t visScalar = 0, visSse = 0, visBvh = 0;
+        BenchTimer tScalar;
+        for (const Frustum& f : frusta)
+            for (const Aabb& b : aabbs) visScalar += f.testScalar(b) != CullResult::Outside;
+        double scalarUs = tScalar.ms() * 1000.0 / cameras;
+
+        BenchTimer tSse;
+        for (const Frustum& f : frusta)
+            for (const Aabb& b : aabbs) visSse += f.test(b) != CullResult::Outside;
+        double sseUs = tSse.ms() * 1000.0 / cameras;
+
+        std::vector<uint32_t> visible;
+        BenchTimer tBvh;
+        for (const Frustum& f : frusta) {
+            visible.clear();
+            bvh.cull(f, visible);
+            visBvh += visible.size();
+        }
+        double bvhUs = tBvh.ms() * 1000.0 / cameras;
+
+        PortalCuller cells;
+        cells.build(desc, boxes.models.data(), boxes.size());
+        size_t visPortal = 0, cellCount = 0;
+        BenchTimer tPortal;
+        for (int c = 0; c < cameras; ++c) {
+            visible.clear();
+            cells.cull(eyes[c], viewProjs[c], visible);
+            visPortal += visible.size();
+            cellCount += cells.cellsVisible();
+        }
+        double portalUs = tPortal.ms() * 1000.0 / cameras;
+
+        if (visScalar != visSse || visSse != visBvh)
+            std::printf("mismatch: scalar %zu, sse %zu, bvh %zu\n", visScalar, visSse, visBvh);
+
+        std::printf("%8d %8zu %10.3f %12.2f %12.2f %12.2f %8.1f%% %12.2f %8.1f%% %7.1f\n",
+            g[0] * g[1], n, buildMs, scalarUs, sseUs, bvhUs, 100.0 * visBvh / ((double)n * cameras),
+            portalUs, 100.0 * visPortal / ((double)n * cameras), (double)cellCount / cameras);
+    }
+    return 0;
+}
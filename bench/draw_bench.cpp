@@ -0,0 +1,87 @@
+// Draw submission as the furniture count grows: `pieces` random coffee
+// tables / TV stands / sofas / boxes are scattered over the living room
+// floor (fixed seed) and the default camera renders it with frustum
+// culling, once copying the visible instances into a compact batch and once
+// drawing them in place with one glMultiDrawElementsIndirect (when the
+// driver has it; otherwise both columns take the copy path). Prints median
+// draw calls, submitted instances, CPU submit time and GPU time per frame.
+//
+// usage: draw_bench [--frames 120] [--size 1280x720] [--scene file]
+
+#include "BenchUtil.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+int main(int argc, char** argv) {
+    int frames = 120, width = 1280, height = 720;
+    std::string scenePath = assetPath("scenes/living_room.scene");
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        bool more = i + 1 < argc;
+        if (a == "--frames" && more) frames = std::atoi(argv[++i]);
+        else if (a == "--size" && more) std::sscanf(argv[++i], "%dx%d", &width, &height);
+        else if (a == "--scene" && more) scenePath = argv[++i];
+        else { std::cerr << "unknown argument " << a << "\n"; return 1; }
+    }
+
+    GLFWwindow* window = createBenchContext(width, height);
+    if (!window) return 1;
+    std::printf("GL %d.%d, multi-draw indirect: %s\n", GLExt::major, GLExt::minor,
+        GLExt::multiDrawIndirect ? "yes" : "no (fallback)");
+    GpuFrameBench bench(width, height);
+
+    struct Result {
+        double draws, instances, cpuMs, gpuMs;
+    };
+
+    auto measure = [&](int pieces, bool indirect) {
+        RoomRenderer renderer;
+        loadBenchScene(renderer, scenePath);
+        renderer.indirectDraws = indirect;
+        const RoomDesc room = benchRoom(renderer.sceneDesc);
+
+        std::mt19937 rng(11);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        const FurnitureType types[] = { FurnitureType::CoffeeTable, FurnitureType::TVStand, FurnitureType::Sofa, FurnitureType::Box };
+        for (int p = 0; p < pieces; ++p) {
+            FurnitureType type = types[rng() % 4];
+            glm::vec3 pos = room.center + glm::vec3((unit(rng) - 0.5f) * room.size.x * 0.9f, 0.0f,
+                (unit(rng) - 0.5f) * room.size.z * 0.9f);
+            if (type == FurnitureType::TVStand) pos.y = 0.5f;
+            if (type == FurnitureType::Box) pos.y = 0.2f;
+            addBenchFurniture(renderer, FurnitureDesc{ type, pos, 360.0f * unit(rng), glm::vec3(type == FurnitureType::Box ? 0.3f : 0.5f),
+                glm::vec3(unit(rng), unit(rng), unit(rng)), 0, 0 }, furnitureName(type));
+        }
+
+        ViewState view;
+        std::vector<double> draws, instances, cpu;
+        const std::vector<double> gpu = bench.run(frames, [&](bool measured) {
+            BenchTimer timer;
+            bench.begin();
+            renderer.renderFrame(view, width, height);
+            bench.end();
+            renderer.endFrame();
+            if (!measured) return;
+            cpu.push_back(timer.ms());
+            draws.push_back((double)renderStats().drawCalls);
+            instances.push_back((double)renderStats().instances);
+        });
+        return Result{ summarize(draws).p50, summarize(instances).p50, summarize(cpu).p50, summarize(gpu).p50 };
+    };
+
+    std::printf("%8s %10s | %7s %8s %8s | %7s %8s %8s\n", "pieces", "instances",
+        "draws", "cpu ms", "gpu ms", "draws", "cpu ms", "gpu ms");
+    std::printf("%19s | %25s | %25s\n", "", "copied batch", "indirect");
+    const int pieceCounts[] = { 16, 64, 256, 1024, 4096 };
+    for (int pieces : pieceCounts) {
+        Result copy = measure(pieces, false);
+        Result mdi = measure(pieces, true);
+        std::printf("%8d %10.0f | %7.0f %8.3f %8.3f | %7.0f %8.3f %8.3f\n", pieces, copy.instances,
+            copy.draws, copy.cpuMs, copy.gpuMs, mdi.draws, mdi.cpuMs, mdi.gpuMs);
+    }
+
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,179 @@
+// Frame-time benchmark with deterministic playback: the camera follows a
+// scripted path at a fixed timestep (no input, no wall-clock dt), renders
+// into an offscreen FBO (no vsync) and reports CPU submit time, GPU time
+// (GL_TIME_ELAPSED queries, read back a few frames late), draw calls,
+// uniform/buffer uploads and GL state calls per frame as percentiles in
+// JSON. --lights adds N random point lights inside the scene's rooms (fixed
+// seed) on top of its own.
+//
+// usage: frame_bench [--frames N] [--warmup N] [--path cam.path] [--scene file]
+//                    [--size WxH] [--fog] [--no-flashlight] [--no-cull] [--occlusion]
+//                    [--lights N] [--deferred] [--prepass] [--out result.json]
+
+#include "BenchUtil.h"
+#include "CameraPath.h"
+#include "GLExt.h"
+#include "GLState.h"
+#include "Offscreen.h"
+#include "RenderStats.h"
+#include "RoomRenderer.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+int main(int argc, char** argv) {
+    int frames = 1000, warmup = 60;
+    int width = 1280, height = 720;
+    std::string pathFile, outFile;
+    std::string scenePath = assetPath("scenes/living_room.scene");
+    ViewState view;
+    bool cull = true, occlusion = false, deferred = false, prepass = false;
+    int extraLights = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        bool more = i + 1 < argc;
+        if (a == "--frames" && more) frames = std::atoi(argv[++i]);
+        else if (a == "--warmup" && more) warmup = std::atoi(argv[++i]);
+        else if (a == "--path" && more) pathFile = argv[++i];
+        else if (a == "--scene" && more) scenePath = argv[++i];
+        else if (a == "--size" && more) std::sscanf(argv[++i], "%dx%d", &width, &height);
+        else if (a == "--out" && more) outFile = argv[++i];
+        else if (a == "--fog") view.fogOn = true;
+        else if (a == "--no-flashlight") view.flashlightOn = false;
+        else if (a == "--no-cull") cull = false;
+        else if (a == "--occlusion") occlusion = true;
+        else if (a == "--lights" && more) extraLights = std::atoi(argv[++i]);
+        else if (a == "--deferred") deferred = true;
+        else if (a == "--prepass") prepass = true;
+        else { std::cerr << "unknown argument " << a << "\n"; return 1; }
+    }
+
+    GLFWwindow* window = createBenchContext(width, height);
+    if (!window) return 1;
+
+    CameraPath path = CameraPath::defaultTour();
+    std::string err;
+    if (!pathFile.empty() && !path.load(pathFile, err)) { std::cerr << err << "\n"; return 1; }
+
+    const int total = warmup + frames;
+    size_t lightCount = 0;
+    std::vector<double> cpuMs(total, 0.0), gpuMs(total, 0.0);
+    std::vector<double> draws, instances, culled, occluded, lightIndices, fragments, uniforms, uploads;
+    std::vector<double> stateCalls, stateSkipped;
+
+    {
+        RoomRenderer renderer;
+        if (!renderer.loadScene(scenePath, err)) { std::cerr << "Scene load failed: " << err << "\n"; return 1; }
+        renderer.textures.finish();
+        renderer.frustumCulling = cull;
+        renderer.occlusionCulling = occlusion;
+        renderer.deferred = deferred;
+        renderer.depthPrepass = prepass;
+
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        for (int l = 0; l < extraLights && !renderer.sceneDesc.rooms.empty(); ++l) {
+            const RoomDesc& room = renderer.sceneDesc.rooms[rng() % renderer.sceneDesc.rooms.size()];
+            glm::vec3 p = room.center + glm::vec3((unit(rng) - 0.5f) * room.size.x, unit(rng) * room.size.y,
+                (unit(rng) - 0.5f) * room.size.z);
+            glm::vec3 color = glm::vec3(0.3f) + 0.7f * glm::vec3(unit(rng), unit(rng), unit(rng));
+            renderer.lights.push_back(LightDesc{ p, color, 2.0f + 3.0f * unit(rng) });
+        }
+        lightCount = renderer.lights.size();
+        OffscreenTarget target(width, height);
+
+        // a small ring of timer queries so reading one never waits on the GPU
+        const int kQueries = 4;
+        GLuint queries[kQueries];
+        int queryFrame[kQueries];
+        glGenQueries(kQueries, queries);
+        for (int& f : queryFrame) f = -1;
+
+        auto collect = [&](int slot) {
+            if (queryFrame[slot] < 0) return;
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(queries[slot], GL_QUERY_RESULT, &ns);
+            gpuMs[queryFrame[slot]] = ns / 1.0e6;
+            queryFrame[slot] = -1;
+        };
+
+        const double dt = 1.0 / 60.0; // fixed timestep
+        const float loop = path.duration() > 0.0f ? path.duration() : 1.0f;
+
+        for (int i = 0; i < total; ++i) {
+            float t = (float)std::fmod(i * dt, (double)loop);
+            path.sample(t, view.camPos, view.camFront);
+
+            int slot = i % kQueries;
+            collect(slot);
+
+            renderStats().reset();
+            BenchTimer timer;
+            glBeginQuery(GL_TIME_ELAPSED, queries[slot]);
+            target.bind();
+            renderer.renderFrame(view, width, height);
+            glEndQuery(GL_TIME_ELAPSED);
+            renderer.endFrame();
+            cpuMs[i] = timer.ms();
+            queryFrame[slot] = i;
+            glFlush(); // stands in for the swap
+
+            if (i >= warmup) {
+                draws.push_back((double)renderStats().drawCalls);
+                instances.push_back((double)renderStats().instances);
+                culled.push_back((double)renderStats().culled);
+                occluded.push_back((double)renderStats().occludedGroups);
+                lightIndices.push_back((double)renderStats().lightIndices);
+                fragments.push_back((double)renderStats().shadedFragments);
+                uniforms.push_back((double)renderStats().uniformUploads);
+                uploads.push_back((double)renderStats().bufferUploads);
+                stateCalls.push_back((double)renderStats().stateCalls);
+                stateSkipped.push_back((double)renderStats().stateSkipped);
+            }
+        }
+        for (int s = 0; s < kQueries; ++s) collect(s);
+        glDeleteQueries(kQueries, queries);
+    }
+
+    std::vector<double> cpu(cpuMs.begin() + warmup, cpuMs.end());
+    std::vector<double> gpu(gpuMs.begin() + warmup, gpuMs.end());
+
+    std::ostringstream json;
+    json << "{\n";
+    json << "  \"renderer\": \"" << jsonEscape((const char*)glGetString(GL_RENDERER)) << "\",\n";
+    json << "  \"scene\": \"" << jsonEscape(scenePath) << "\",\n";
+    json << "  \"frames\": " << frames << ",\n";
+    json << "  \"warmup\": " << warmup << ",\n";
+    json << "  \"width\": " << width << ",\n";
+    json << "  \"height\": " << height << ",\n";
+    json << "  \"frustum_culling\": " << (cull ? "true" : "false") << ",\n";
+    json << "  \"occlusion_culling\": " << (occlusion ? "true" : "false") << ",\n";
+    json << "  \"lights\": " << lightCount << ",\n";
+    json << "  \"deferred\": " << (deferred ? "true" : "false") << ",\n";
+    json << "  \"depth_prepass\": " << (prepass ? "true" : "false") << ",\n";
+    json << "  \"metrics\": {\n";
+    writeSummaryJson(json, "cpu_ms", summarize(cpu));
+    writeSummaryJson(json, "gpu_ms", summarize(gpu));
+    writeSummaryJson(json, "draw_calls", summarize(draws));
+    writeSummaryJson(json, "instances", summarize(instances));
+    writeSummaryJson(json, "culled", summarize(culled));
+    writeSummaryJson(json, "occluded_groups", summarize(occluded));
+    writeSummaryJson(json, "light_indices", summarize(lightIndices));
+    writeSummaryJson(json, "shaded_fragments", summarize(fragments));
+    writeSummaryJson(json, "uniform_uploads", summarize(uniforms));
+    writeSummaryJson(json, "buffer_uploads", summarize(uploads));
+    writeSummaryJson(json, "state_calls", summarize(stateCalls));
+    writeSummaryJson(json, "state_skipped", summarize(stateSkipped), true);
+    json << "  }\n}\n";
+
+    if (outFile.empty()) std::cout << json.str();
+    else std::ofstream(outFile) << json.str();
+
+    glfwTerminate();
+    return 0;
+}
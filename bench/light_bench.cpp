@@ -0,0 +1,66 @@
+// Clustered light assignment cost (CPU only, no GL context): random point
+// lights scattered over a 4 x 3 apartment-sized block, binned for random
+// camera poses, on the calling thread alone and on the full worker pool.
+// "per cluster" is the mean list length over clusters that have any light,
+// i.e. what a lit fragment loops over instead of every light.
+//
+// usage: light_bench [cameras=256]
+
+#include "BenchUtil.h"
+#include "CameraPath.h"
+#include "LightClusters.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+int main(int argc, char** argv) {
+    int cameras = argc > 1 ? std::atoi(argv[1]) : 256;
+    const float zNear = 0.1f, zFar = 100.0f;
+    const glm::mat4 proj = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, zNear, zFar);
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> x(-5.0f, 35.0f), y(0.0f, 4.0f), z(-35.0f, 7.0f), unit(0.0f, 1.0f);
+    std::uniform_real_distribution<float> yaw(0.0f, 360.0f), pitch(-20.0f, 20.0f);
+    std::vector<glm::mat4> views;
+    for (int c = 0; c < cameras; ++c) {
+        glm::vec3 pos(x(rng), 1.5f, z(rng));
+        glm::vec3 front = frontFromYawPitch(yaw(rng), pitch(rng));
+        views.push_back(glm::lookAt(pos, pos + front, glm::vec3(0, 1, 0)));
+    }
+
+    LightClusters single(0), pooled;
+    std::printf("%8s %14s %14s %9s %12s\n", "lights", "1 thread us", "pooled us", "threads", "per cluster");
+    const int counts[] = { 16, 64, 256, 1024, 4096 };
+    for (int n : counts) {
+        std::vector<LightDesc> lights(n);
+        for (LightDesc& l : lights)
+            l = LightDesc{ glm::vec3(x(rng), y(rng), z(rng)), glm::vec3(unit(rng), unit(rng), unit(rng)), 2.0f + 3.0f * unit(rng) };
+
+        BenchTimer tSingle;
+        for (const glm::mat4& v : views) single.assign(lights, v, proj, zNear, zFar);
+        double singleUs = tSingle.ms() * 1000.0 / cameras;
+
+        BenchTimer tPooled;
+        for (const glm::mat4& v : views) pooled.assign(lights, v, proj, zNear, zFar);
+        double pooledUs = tPooled.ms() * 1000.0 / cameras;
+
+        double perCluster = 0.0;
+        int lit = 0;
+        for (const glm::mat4& v : views) {
+            pooled.assign(lights, v, proj, zNear, zFar);
+            if (!pooled.occupiedClusters()) continue;
+            perCluster += (double)pooled.indexCount() / pooled.occupiedClusters();
+            ++lit;
+        }
+
+        if (pooled.indexCount() != single.indexCount())
+            std::printf("mismatch: single %zu, pooled %zu\n", single.indexCount(), pooled.indexCount());
+
+        std::printf("%8d %14.1f %14.1f %9u %12.2f\n", n, singleUs, pooledUs, pooled.threadCount(),
+            lit ? perCluster / lit : 0.0);
+    }
+    return 0;
+}
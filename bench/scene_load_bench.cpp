@@ -0,0 +1,131 @@
+// Scene load time, text (.scene) vs binary (.rscn), each taken through what
+// RoomRenderer::loadScene does: populateScene into a BakedScene, bake(), and
+// the instance streams uploaded to GL (one draw with rasterization off, then
+// glFinish). Text reads, parses and runs every generator; binary maps,
+// validates and uploads the baked streams from the mapping.
+// Writes `layouts` random living-room layouts to a temp directory first.
+//
+// usage: scene_load_bench [layouts=1000] [furniturePerRoom=40]
+
+#include "BenchUtil.h"
+#include "SceneFile.h"
+#include "BakedScene.h"
+#include "Cube.h"
+#include "MeshPool.h"
+#include "shader.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+static std::string randomLayout(std::mt19937& rng, int furniture) {
+    std::uniform_real_distribution<float> x(-4.0f, 4.0f), z(-6.0f, 6.0f), yaw(0.0f, 360.0f);
+    std::ostringstream s;
+    s << "room 0 0 0  10 4 14  6B8E23 E0E0E0 C0D6FF C0D6FF ADD8E6\n";
+    s << "light 0 3 2.5  1 1 1\n";
+    s << "light 0 1 -2.2  1 0.95 0.8\n";
+    for (int i = 0; i < furniture; ++i) {
+        switch (i % 4) {
+        case 0: s << "coffee_table " << x(rng) << " 0 " << z(rng) << " " << yaw(rng) << " 1\n"; break;
+        case 1: s << "tv_stand " << x(rng) << " 0.5 " << z(rng) << "\n"; break;
+        case 2: s << "sofa " << x(rng) << " 0 " << z(rng) << " " << yaw(rng) << "\n"; break;
+        case 3: s << "box " << x(rng) << " 1 " << z(rng) << " 0.3 0.3 0.3 FFF2B2\n"; break;
+        }
+    }
+    return s.str();
+}
+
+int main(int argc, char** argv) {
+    int layouts = argc > 1 ? std::atoi(argv[1]) : 1000;
+    int furniture = argc > 2 ? std::atoi(argv[2]) : 40;
+
+    fs::path dir = fs::temp_directory_path() / "finalroom_scene_bench";
+    fs::create_directories(dir);
+
+    // --- generate inputs (not timed) ---
+    std::mt19937 rng(1234);
+    size_t textBytes = 0, binBytes = 0;
+    for (int i = 0; i < layouts; ++i) {
+        std::string text = randomLayout(rng, furniture);
+        textBytes += text.size();
+        std::string base = (dir / ("room" + std::to_string(i))).string();
+        { std::FILE* f = std::fopen((base + ".scene").c_str(), "wb"); std::fwrite(text.data(), 1, text.size(), f); std::fclose(f); }
+
+        SceneDesc desc; std::string err;
+        parseSceneText(text.c_str(), text.size(), desc, err);
+        saveSceneBinary(base + ".rscn", desc);
+        binBytes += (size_t)fs::file_size(base + ".rscn");
+    }
+
+    GLFWwindow* window = createBenchContext(64, 64);
+    if (!window) return 1;
+
+    size_t instances = 0, mappedInstances = 0;
+    double textMs = 0.0, binMs = 0.0;
+    {
+        // GL objects must go before glfwTerminate
+        MeshPool meshes;
+        const Mesh cube = Cube::addTo(meshes);
+        meshes.upload();
+        unsigned int vao = 0;
+        glGenVertexArrays(1, &vao);
+        meshes.setupVAO(vao);
+        // any program that reads the instance streams; nothing is rasterized
+        Shader depth(assetPath("src/depth.vert").c_str(), assetPath("src/depth.frag").c_str());
+        depth.use();
+        glEnable(GL_RASTERIZER_DISCARD);
+
+        // populate + bake + upload, the way RoomRenderer::loadScene does
+        auto finish = [&](BakedScene& scene) {
+            scene.bake();
+            glState().bindVertexArray(vao);
+            scene.draw();
+            glFinish();
+            return scene.boxes.size();
+        };
+
+        // --- text: read + parse + run every generator + upload ---
+        BenchTimer tText;
+        for (int i = 0; i < layouts; ++i) {
+            SceneDesc desc; std::string err;
+            if (!loadSceneText((dir / ("room" + std::to_string(i) + ".scene")).string(), desc, err)) {
+                std::cerr << err << "\n"; return 1;
+            }
+            BakedScene scene;
+            scene.boxes.attach(vao, cube);
+            populateScene(scene, desc);
+            instances += finish(scene);
+        }
+        textMs = tText.ms();
+
+        // --- binary: map + validate + upload straight from the mapping ---
+        BenchTimer tBin;
+        for (int i = 0; i < layouts; ++i) {
+            MappedScene m; std::string err;
+            if (!m.open((dir / ("room" + std::to_string(i) + ".rscn")).string(), err)) {
+                std::cerr << err << "\n"; return 1;
+            }
+            BakedScene scene;
+            scene.boxes.attach(vao, cube);
+            populateScene(scene, m);
+            mappedInstances += finish(scene);
+        }
+        binMs = tBin.ms();
+        glState().deleteVertexArrays(1, &vao);
+    }
+
+    std::cout << "layouts: " << layouts << ", instances: " << instances
+              << " (binary " << mappedInstances << ")\n";
+    std::cout << "text   : " << textMs * 1000.0 / layouts << " us/layout, "
+              << (textBytes / 1e6) / (textMs / 1000.0) << " MB/s\n";
+    std::cout << "binary : " << binMs * 1000.0 / layouts << " us/layout, "
+              << (binBytes / 1e6) / (binMs / 1000.0) << " MB/s\n";
+
+    fs::remove_all(dir);
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,110 @@
+// Startup cost of the renderer's programs (room, gbuffer, deferred, depth,
+// texture): wall time from reading the sources to every program linked and
+// reflected, four ways:
+//   source, one by one     compile + link each program before the next (the old Shader)
+//   source, side by side   issue every compile / link, then finish them all
+//                          (overlaps on driver threads with KHR_parallel_shader_compile)
+//   cache cold             side by side with the ShaderCache open but empty:
+//                          compile, then glGetProgramBinary to disk
+//   cache warm             the same sources again: glProgramBinary from disk
+// Every run appends a fresh comment to the sources, so neither the driver's
+// own shader cache nor an earlier run can serve a "cold" compile. Prints the
+// median and the fastest run of each.
+//
+// usage: shader_bench [--runs 5] [--cache-dir dir]
+
+#include "BenchUtil.h"
+#include "GLExt.h"
+#include "ShaderCache.h"
+#include "shader.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+int main(int argc, char** argv) {
+    int runs = 5;
+    std::string cacheDir = assetPath(".shadercache/bench");
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        bool more = i + 1 < argc;
+        if (a == "--runs" && more) runs = std::max(1, std::atoi(argv[++i]));
+        else if (a == "--cache-dir" && more) cacheDir = argv[++i];
+        else { std::cerr << "unknown argument " << a << "\n"; return 1; }
+    }
+
+    GLFWwindow* window = createBenchContext(64, 64);
+    if (!window) return 1;
+
+    const char* programs[][2] = {
+        { "src/room.vert", "src/room.frag" },
+        { "src/room.vert", "src/gbuffer.frag" },
+        { "src/deferred.vert", "src/deferred.frag" },
+        { "src/depth.vert", "src/depth.frag" },
+        { "src/texture.vert", "src/texture.frag" },
+    };
+    const size_t programCount = sizeof(programs) / sizeof(programs[0]);
+
+    // the sources with a unique trailing comment
+    auto sources = [&]() {
+        const long long nonce = (long long)std::chrono::system_clock::now().time_since_epoch().count();
+        const std::string salt = "\n// " + std::to_string(nonce) + "\n";
+        std::vector<ShaderSource> out;
+        for (auto& p : programs) {
+            ShaderSource s = Shader::load(assetPath(p[0]).c_str(), assetPath(p[1]).c_str());
+            s.vertex += salt;
+            s.fragment += salt;
+            out.push_back(std::move(s));
+        }
+        return out;
+    };
+
+    // ms until every program is usable; glFinish so a driver that defers
+    // work past the link status query still pays for it here
+    auto build = [&](const std::vector<ShaderSource>& src, bool sideBySide) {
+        glFinish();
+        BenchTimer t;
+        std::vector<std::unique_ptr<Shader>> shaders;
+        for (const ShaderSource& s : src) shaders.push_back(std::make_unique<Shader>(s, !sideBySide));
+        for (auto& s : shaders) s->finish();
+        glFinish();
+        const double ms = t.ms();
+        for (auto& s : shaders) glState().deleteProgram(s->ID);
+        return ms;
+    };
+
+    ShaderCache& cache = shaderCache();
+    std::vector<double> oneByOne, sideBySide, cold, warm;
+    for (int r = 0; r < runs; ++r) {
+        cache.close();
+        oneByOne.push_back(build(sources(), false));
+        sideBySide.push_back(build(sources(), true));
+
+        cache.open(cacheDir);
+        cache.clear();
+        const std::vector<ShaderSource> src = sources();
+        cold.push_back(build(src, true));
+        warm.push_back(build(src, true));
+    }
+    cache.clear();
+
+    std::printf("%zu programs, %d runs; %s\n", programCount, runs, (const char*)glGetString(GL_RENDERER));
+    std::printf("program binaries: %s, parallel compile: %s\n",
+        GLExt::programBinary ? "yes" : "no (cache rows compile from source)",
+        GLExt::parallelShaderCompile ? "yes" : "no");
+    std::printf("%-24s %10s %10s\n", "", "p50 ms", "min ms");
+    auto row = [](const char* label, const std::vector<double>& v) {
+        const Summary s = summarize(v);
+        std::printf("%-24s %10.2f %10.2f\n", label, s.p50, s.min);
+    };
+    row("source, one by one", oneByOne);
+    row("source, side by side", sideBySide);
+    row("cache cold", cold);
+    row("cache warm", warm);
+    std::printf("cache: %llu hits, %llu misses, %llu rejected\n",
+        (unsigned long long)cache.hits, (unsigned long long)cache.misses, (unsigned long long)cache.rejected);
+
+    glfwTerminate();
+    return 0;
+}
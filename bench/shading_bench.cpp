@@ -0,0 +1,92 @@
+// Forward, forward with a depth pre-pass and deferred shading as light
+// count and overdraw grow. The living
+// room is seen from the default camera; `layers` full-width panels are
+// stacked between the camera and the back wall and drawn back to front
+// (culling off, so submission order is scene order), which makes every
+// panel pixel a fragment the forward path lights and then overwrites.
+// Extra lights are scattered through the room (fixed seed). Prints the
+// median GPU time per frame (GL_TIME_ELAPSED) for all three paths, and the
+// fragments the lit forward pass shaded (GL_SAMPLES_PASSED) with and
+// without the pre-pass; deferred lights width x height pixels.
+//
+// usage: shading_bench [--frames 60] [--size 1280x720] [--scene file]
+
+#include "BenchUtil.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+int main(int argc, char** argv) {
+    int frames = 60, width = 1280, height = 720;
+    std::string scenePath = assetPath("scenes/living_room.scene");
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        bool more = i + 1 < argc;
+        if (a == "--frames" && more) frames = std::atoi(argv[++i]);
+        else if (a == "--size" && more) std::sscanf(argv[++i], "%dx%d", &width, &height);
+        else if (a == "--scene" && more) scenePath = argv[++i];
+        else { std::cerr << "unknown argument " << a << "\n"; return 1; }
+    }
+
+    GLFWwindow* window = createBenchContext(width, height);
+    if (!window) return 1;
+    GpuFrameBench bench(width, height);
+
+    struct Result {
+        double ms;               // median GPU time
+        uint64_t fragments;      // lit forward pass, last frame reported
+    };
+
+    auto measure = [&](int lightCount, int layers, bool deferred, bool prepass) {
+        RoomRenderer renderer;
+        loadBenchScene(renderer, scenePath);
+        renderer.frustumCulling = false;
+        renderer.deferred = deferred;
+        renderer.depthPrepass = prepass;
+        const RoomDesc room = benchRoom(renderer.sceneDesc);
+
+        // panels from the back wall towards the camera
+        for (int l = 0; l < layers; ++l) {
+            float z = room.center.z - room.size.z * 0.45f + room.size.z * 0.8f * l / layers;
+            addBenchFurniture(renderer, FurnitureDesc{ FurnitureType::Box, glm::vec3(room.center.x, room.size.y * 0.5f, z), 0.0f,
+                glm::vec3(room.size.x * 0.98f, room.size.y * 0.98f, 0.05f), glm::vec3(0.5f + 0.4f * (l & 1), 0.6f, 0.7f), 0, 0 },
+                "panel");
+        }
+
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        while ((int)renderer.lights.size() < lightCount) {
+            glm::vec3 p = room.center + glm::vec3((unit(rng) - 0.5f) * room.size.x, unit(rng) * room.size.y,
+                (unit(rng) - 0.5f) * room.size.z);
+            renderer.lights.push_back(LightDesc{ p, glm::vec3(0.3f) + 0.7f * glm::vec3(unit(rng), unit(rng), unit(rng)),
+                2.0f + 3.0f * unit(rng) });
+        }
+
+        ViewState view;
+        const std::vector<double> gpu = bench.run(frames, [&](bool) {
+            bench.begin();
+            renderer.renderFrame(view, width, height);
+            bench.end();
+            renderer.endFrame();
+        });
+        return Result{ summarize(gpu).p50, renderStats().shadedFragments };
+    };
+
+    std::printf("%8s %8s %12s %12s %12s %12s %12s\n", "lights", "layers", "forward ms", "prepass ms",
+        "deferred ms", "fwd frags", "prepass frags");
+    const int lightCounts[] = { 2, 16, 64, 256, 1024 };
+    const int layerCounts[] = { 0, 4, 16 };
+    for (int layers : layerCounts) {
+        for (int lights : lightCounts) {
+            Result fwd = measure(lights, layers, false, false);
+            Result pre = measure(lights, layers, false, true);
+            Result def = measure(lights, layers, true, false);
+            std::printf("%8d %8d %12.3f %12.3f %12.3f %12llu %12llu\n", lights, layers, fwd.ms, pre.ms, def.ms,
+                (unsigned long long)fwd.fragments, (unsigned long long)pre.fragments);
+        }
+    }
+
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,151 @@
+// Frame times while a texture catalog loads. The living room is rendered
+// every frame from the default camera while a TextureLoader brings in the
+// catalog, once synchronously (decode and upload everything inside the
+// first update(), what a plain stbi_load + glTexImage2D loop does), once
+// asynchronously (decode workers, PBO ring, per-frame upload budget), and,
+// when tools/texture_cook has been run on the catalog, the same two for the
+// cooked .rtex files (mapped, block-compressed, mips included). Every frame
+// ends in glFinish, so its time includes the GPU side of the uploads.
+// Prints frames and wall time until the last texture is ready, median /
+// p99 / worst frame time over that stretch, and the video memory the
+// loaded textures take.
+//
+// Before that it round-trips a few 4x4 checkers of two colors at equal
+// brightness (red / green, ...) through the BC1 encoder and fails if the
+// two colors do not come back: blocks whose colors differ only in hue.
+//
+// usage: texture_bench [--textures a.jpg,b.jpg] [--threads 2] [--budget-mb 4]
+//                      [--max-size 2048] [--size 1280x720] [--scene file]
+
+#include "BenchUtil.h"
+#include "GLExt.h"
+#include "GLState.h"
+#include "Offscreen.h"
+#include "RoomRenderer.h"
+#include "TextureFile.h"
+#include "TextureLoader.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <sstream>
+
+int main(int argc, char** argv) {
+    int width = 1280, height = 720, threads = 2, budgetMb = 4, maxSize = 2048;
+    std::string scenePath = assetPath("scenes/living_room.scene");
+    std::vector<std::string> catalog = { assetPath("textures/wall.jpg"), assetPath("textures/fabric.jpg") };
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        bool more = i + 1 < argc;
+        if (a == "--textures" && more) {
+            catalog.clear();
+            std::stringstream list(argv[++i]);
+            for (std::string t; std::getline(list, t, ',');) catalog.push_back(t);
+        }
+        else if (a == "--threads" && more) threads = std::atoi(argv[++i]);
+        else if (a == "--budget-mb" && more) budgetMb = std::atoi(argv[++i]);
+        else if (a == "--max-size" && more) maxSize = std::atoi(argv[++i]);
+        else if (a == "--size" && more) std::sscanf(argv[++i], "%dx%d", &width, &height);
+        else if (a == "--scene" && more) scenePath = argv[++i];
+        else { std::cerr << "unknown argument " << a << "\n"; return 1; }
+    }
+
+    {
+        // equal-brightness pairs: no spread along grey, all of it in hue
+        const uint8_t pairs[][2][3] = {
+            { { 255, 0, 0 }, { 0, 255, 0 } },
+            { { 0, 255, 0 }, { 0, 0, 255 } },
+            { { 255, 0, 0 }, { 0, 0, 255 } },
+            { { 200, 60, 120 }, { 60, 200, 120 } },
+        };
+        int worst = 0;
+        for (const auto& pair : pairs) {
+            uint8_t block[64], packed[8], back[64];
+            for (int i = 0; i < 16; ++i) {
+                const uint8_t* c = pair[((i & 3) + (i >> 2)) & 1];
+                for (int ch = 0; ch < 3; ++ch) block[i * 4 + ch] = c[ch];
+                block[i * 4 + 3] = 255;
+            }
+            encodeBC1Block(block, packed);
+            decodeBC1Block(packed, back);
+            for (int i = 0; i < 64; ++i)
+                if (i % 4 != 3) worst = std::max(worst, std::abs(block[i] - back[i]));
+        }
+        // 565 rounding plus the 1/16 inset of the endpoints
+        std::printf("BC1 two-color round trip: max channel error %d\n", worst);
+        if (worst > 32) { std::cerr << "BC1 encoder lost a hue-only block\n"; return 1; }
+    }
+
+    GLFWwindow* window = createBenchContext(width, height);
+    if (!window) return 1;
+
+    {
+        // GL objects must go before glfwTerminate
+        OffscreenTarget target(width, height);
+        RoomRenderer renderer;
+        std::string err;
+        if (!renderer.loadScene(scenePath, err)) { std::cerr << "Scene load failed: " << err << "\n"; return 1; }
+        renderer.textures.finish();   // the scene's materials, so only the catalog loads below
+        ViewState view;
+
+        struct Result {
+            int frames;
+            double loadMs;
+            Summary frame;
+            size_t vram;
+        };
+
+        auto measure = [&](const std::vector<std::string>& paths, int workerThreads, size_t budget) {
+            // warm up the renderer so the first measured frame is a normal one
+            for (int f = 0; f < 5; ++f) {
+                target.bind();
+                renderer.renderFrame(view, width, height);
+                renderer.endFrame();
+            }
+            glFinish();
+
+            TextureLoader textures(workerThreads, budget, maxSize);
+            BenchTimer load;
+            for (const std::string& t : paths) textures.request(t);
+            std::vector<double> frames;
+            while (textures.pending() > 0 && frames.size() < 100000) {
+                BenchTimer frame;
+                textures.update();
+                target.bind();
+                renderer.renderFrame(view, width, height);
+                renderer.endFrame();
+                glFinish();
+                frames.push_back(frame.ms());
+            }
+            return Result{ (int)frames.size(), load.ms(), summarize(frames), textures.residentBytes() };
+        };
+
+        std::vector<std::string> cooked;
+        for (const std::string& t : catalog) {
+            std::string c = cookedTexturePath(t);
+            if (c != t) cooked.push_back(c);
+        }
+
+        std::printf("%zu textures, max size %d\n", catalog.size(), maxSize);
+        std::printf("%-30s %8s %10s %10s %10s %10s %10s\n", "", "frames", "load ms", "p50 ms", "p99 ms", "max ms", "vram MB");
+        auto row = [&](const char* label, const std::vector<std::string>& paths, int workerThreads, size_t budget) {
+            const Result r = measure(paths, workerThreads, budget);
+            std::printf("%-30s %8d %10.1f %10.3f %10.3f %10.3f %10.1f\n", label,
+                r.frames, r.loadMs, r.frame.p50, r.frame.p99, r.frame.max, r.vram / (1024.0 * 1024.0));
+        };
+        char asyncLabel[64];
+        std::snprintf(asyncLabel, sizeof(asyncLabel), "async (%d threads, %d MB)", threads, budgetMb);
+        const size_t unlimited = std::numeric_limits<size_t>::max();
+        row("source, sync", catalog, 0, unlimited);
+        row((std::string("source, ") + asyncLabel).c_str(), catalog, threads, (size_t)budgetMb << 20);
+        if (cooked.size() == catalog.size()) {
+            row("cooked, sync", cooked, 0, unlimited);
+            row((std::string("cooked, ") + asyncLabel).c_str(), cooked, threads, (size_t)budgetMb << 20);
+        } else {
+            std::printf("(no .rtex next to every source; run texture_cook on them for the cooked rows)\n");
+        }
+    }
+    glfwTerminate();
+    return 0;
+}
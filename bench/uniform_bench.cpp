@@ -0,0 +1,71 @@
+// Per-frame CPU cost of uniform uploads: the old path (std::string +
+// glGetUniformLocation on every call) vs Shader's reflected location cache.
+//
+// usage: uniform_bench [frames=2000] [objectsPerFrame=500]
+
+#include "BenchUtil.h"
+#include "shader.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cstdlib>
+
+// what shader.h did before the cache: one string + one driver lookup per call
+struct LegacySetter {
+    unsigned int prog;
+    static LegacySetter of(const Shader& sh) { return { sh.ID }; }
+    void mat4(const std::string& n, const glm::mat4& m) const { glUniformMatrix4fv(glGetUniformLocation(prog, n.c_str()), 1, GL_FALSE, glm::value_ptr(m)); }
+    void i(const std::string& n, int v) const { glUniform1i(glGetUniformLocation(prog, n.c_str()), v); }
+};
+
+struct CachedSetter {
+    const Shader* sh;
+    static CachedSetter of(const Shader& sh) { return { &sh }; }
+    void mat4(UniformName n, const glm::mat4& m) const { sh->setMat4(n, m); }
+    void i(UniformName n, int v) const { sh->setInt(n, v); }
+};
+
+// two uploads per textured object, which is what the non-instanced textured
+// path does (camera/light globals live in the FrameUniforms UBO now)
+template <class Setter>
+static double runFrames(const Shader& tex, int frames, int objects) {
+    BenchTimer t;
+    for (int fr = 0; fr < frames; ++fr) {
+        tex.use();
+        Setter s = Setter::of(tex);
+        for (int o = 0; o < objects; ++o) {
+            glm::mat4 M = glm::translate(glm::mat4(1.0f), glm::vec3(float(o % 10), 0.0f, float(o / 10)));
+            s.mat4("model", M);
+            s.i("useTexture", o & 1);
+        }
+    }
+    double ms = t.ms();
+    glFinish();
+    return ms;
+}
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? std::atoi(argv[1]) : 2000;
+    int objects = argc > 2 ? std::atoi(argv[2]) : 500;
+
+    GLFWwindow* window = createBenchContext();
+    if (!window) return 1;
+
+    Shader tex(assetPath("shaders/Texture.vert").c_str(), assetPath("shaders/texture.frag").c_str());
+
+    // warm up both paths once so first-use driver work isn't counted
+    runFrames<LegacySetter>(tex, 10, objects);
+    runFrames<CachedSetter>(tex, 10, objects);
+
+    double legacy = runFrames<LegacySetter>(tex, frames, objects);
+    double cached = runFrames<CachedSetter>(tex, frames, objects);
+
+    int callsPerFrame = 2 * objects;
+    std::cout << "frames: " << frames << ", uniform calls/frame: " << callsPerFrame << "\n";
+    std::cout << "no cache : " << legacy * 1000.0 / frames << " us/frame\n";
+    std::cout << "cache    : " << cached * 1000.0 / frames << " us/frame\n";
+    std::cout << "speedup  : " << (cached > 0.0 ? legacy / cached : 0.0) << "x\n";
+
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,137 @@
+// Vertex throughput of the cube layouts: the old 36-vertex, non-indexed
+// float position + normal (24 bytes a vertex), the same 24-byte vertices
+// indexed (24 vertices, 36 indices), and Cube's indexed PackedVertex
+// (half position, 10:10:10:2 normal, 12 bytes). `instances` tiny cubes are
+// drawn with the position-only depth program into a 1-pixel-ish footprint
+// each, so the GPU time is vertex fetch + shading, not rasterization.
+// Prints the median GPU ms per frame and million cubes per second.
+//
+// usage: vertex_bench [--instances 200000] [--frames 100]
+
+#include "BenchUtil.h"
+#include "Cube.h"
+#include "FrameUniforms.h"
+#include "shader.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+int main(int argc, char** argv) {
+    int instances = 200000, frames = 100;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        bool more = i + 1 < argc;
+        if (a == "--instances" && more) instances = std::atoi(argv[++i]);
+        else if (a == "--frames" && more) frames = std::atoi(argv[++i]);
+        else { std::cerr << "unknown argument " << a << "\n"; return 1; }
+    }
+
+    const int width = 1280, height = 720;
+    GLFWwindow* window = createBenchContext(width, height);
+    if (!window) return 1;
+
+    {
+        // GL objects must go before glfwTerminate
+        GpuFrameBench bench(width, height);
+        Shader depth(assetPath("src/depth.vert").c_str(), assetPath("src/depth.frag").c_str());
+        FrameUniforms frameUniforms;
+
+        // tiny cubes spread over the view
+        std::vector<glm::mat4> models(instances);
+        std::mt19937 rng(3);
+        std::uniform_real_distribution<float> xy(-4.0f, 4.0f), z(-12.0f, -4.0f), yaw(0.0f, 6.28f);
+        for (glm::mat4& m : models) {
+            m = glm::translate(glm::mat4(1.0f), glm::vec3(xy(rng), xy(rng) * 0.6f, z(rng)));
+            m = glm::rotate(m, yaw(rng), glm::vec3(0.3f, 1.0f, 0.2f));
+            m = glm::scale(m, glm::vec3(0.004f));
+        }
+        GLuint instanceVBO;
+        glGenBuffers(1, &instanceVBO);
+        glState().bindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, models.size() * sizeof(glm::mat4), models.data(), GL_STATIC_DRAW);
+
+        auto attachInstances = [&]() {
+            glState().bindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+            for (unsigned int i = 0; i < 4; ++i) {
+                glVertexAttribPointer(2 + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(i * sizeof(glm::vec4)));
+                glEnableVertexAttribArray(2 + i);
+                glVertexAttribDivisor(2 + i, 1);
+            }
+        };
+
+        // old layouts, rebuilt from Cube's data: float x y z nx ny nz
+        std::vector<float> expanded;
+        for (uint32_t idx : Cube::kIndices)
+            expanded.insert(expanded.end(), Cube::kVertices + idx * 6, Cube::kVertices + idx * 6 + 6);
+
+        GLuint vaos[2], buffers[3];
+        glGenVertexArrays(2, vaos);
+        glGenBuffers(3, buffers);
+        auto floatVAO = [&](GLuint vao, GLuint vbo, const float* data, size_t floats) {
+            glState().bindVertexArray(vao);
+            glState().bindBuffer(GL_ARRAY_BUFFER, vbo);
+            glBufferData(GL_ARRAY_BUFFER, floats * sizeof(float), data, GL_STATIC_DRAW);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+            glEnableVertexAttribArray(1);
+            attachInstances();
+        };
+        floatVAO(vaos[0], buffers[0], expanded.data(), expanded.size());
+        floatVAO(vaos[1], buffers[1], Cube::kVertices, Cube::kVertexCount * 6);
+        glState().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[2]);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(Cube::kIndices), Cube::kIndices, GL_STATIC_DRAW);
+
+        Cube cube;
+        glState().bindVertexArray(cube.VAO);
+        attachInstances();
+        glState().bindVertexArray(0);
+
+        FrameUniformsData frame{};
+        frame.view = glm::mat4(1.0f);
+        frame.projection = glm::perspective(glm::radians(45.0f), (float)width / height, 0.1f, 100.0f);
+
+        auto measure = [&](GLuint vao, bool indexed) {
+            depth.use();
+            const std::vector<double> gpu = bench.run(frames, [&](bool) {
+                glViewport(0, 0, width, height);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                frameUniforms.update(frame);
+                glState().bindVertexArray(vao);
+                bench.begin();
+                if (indexed) glDrawElementsInstanced(GL_TRIANGLES, Cube::kIndexCount, GL_UNSIGNED_INT, nullptr, instances);
+                else glDrawArraysInstanced(GL_TRIANGLES, 0, 36, instances);
+                bench.end();
+                frameUniforms.endFrame();
+            });
+            return summarize(gpu).p50;
+        };
+
+        struct Layout {
+            const char* name;
+            GLuint vao;
+            bool indexed;
+            int bytes;   // vertex + index data of one cube
+        };
+        const Layout layouts[] = {
+            { "float, 36 verts", vaos[0], false, 36 * 24 },
+            { "float, indexed", vaos[1], true, 24 * 24 + 36 * 4 },
+            { "packed, indexed", cube.VAO, true, 24 * (int)sizeof(PackedVertex) + 36 * 4 },
+        };
+
+        std::printf("%d cubes\n%-18s %8s %10s %12s\n", instances, "layout", "bytes", "gpu ms", "Mcubes/s");
+        for (const Layout& l : layouts) {
+            double ms = measure(l.vao, l.indexed);
+            std::printf("%-18s %8d %10.3f %12.1f\n", l.name, l.bytes, ms, ms > 0.0 ? instances / (ms * 1000.0) : 0.0);
+        }
+
+        glState().deleteVertexArrays(2, vaos);
+        glState().deleteBuffers(3, buffers);
+        glState().deleteBuffers(1, &instanceVBO);
+    }
+    glfwTerminate();
+    return 0;
+}
@@ -9,8 +9,8 @@ out vec3 Normal;
 out vec2 TexCoord;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform mat3 normalMatrix;   // inverse-transpose of model, computed on the CPU
+#include "../src/frame_uniforms.glsl"
 
 void main()
 {
@@ -18,7 +18,7 @@ void main()
     FragPos = vec3(model * vec4(aPos, 1.0));
 
     // Normal transformed into world space
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    Normal = normalMatrix * aNormal;
 
     // Pass UV coordinates to fragment shader
     TexCoord = aTexCoord;
@@ -20,7 +20,7 @@ in vec2 TexCoord;
 
 out vec4 FragColor;
 
-uniform vec3 viewPos;
+#include "../src/frame_uniforms.glsl"
 uniform Material material;
 uniform DirLight dirLight;
 
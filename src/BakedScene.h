@@ -0,0 +1,114 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "BoxBatch.h"
+#include "Furniture.h"
+
+// Static scene baking. Each item is a generator (a room shell, a
+// drawCoffeeTable call with fixed arguments, ...) that is evaluated once into
+// a contiguous range of the SoA instance arrays. After that the frame only
+// draws; an item is re-evaluated only when marked dirty (e.g. it was moved).
+class BakedScene {
+public:
+    using Generator = std::function<void(const FurnitureContext&)>;
+
+    BoxBatch boxes;  // baked instances of every item, back to back
+
+    // register a generator; it runs on the next bake(). The label names the
+    // item in profiler output ("room", "sofa", ...)
+    int add(Generator gen, const char* label = "item") {
+        items.push_back({ std::move(gen), label, 0, 0, BoxMaterial(), true });
+        layoutChanged = true;
+        return (int)items.size() - 1;
+    }
+
+    // register an item whose boxes are already in `boxes` at [first, first + count)
+    // (e.g. uploaded from a mapped scene file); it runs only if marked dirty
+    int addBaked(Generator gen, size_t first, size_t count, const char* label = "item") {
+        items.push_back({ std::move(gen), label, first, count, BoxMaterial(), false });
+        return (int)items.size() - 1;
+    }
+
+    // replace an item's generator (new arguments) and re-bake it
+    void set(int id, Generator gen) {
+        items[id].gen = std::move(gen);
+        markDirty(id);
+    }
+
+    void markDirty(int id) { items[id].dirty = true; }
+
+    // texture every box of an item (applied now and after each re-bake);
+    // an untextured material leaves what the generator emitted
+    void setMaterial(size_t id, const BoxMaterial& m) {
+        Item& it = items[id];
+        it.material = m;
+        if (it.count > 0) boxes.setMaterial(it.first, it.count, m);
+    }
+
+    size_t itemCount() const { return items.size(); }
+    const char* itemLabel(size_t id) const { return items[id].label; }
+    // instance range [first, first + count) of a baked item
+    size_t itemFirst(size_t id) const { return items[id].first; }
+    size_t itemBoxes(size_t id) const { return items[id].count; }
+
+    // re-evaluate dirty items; returns how many items were evaluated
+    int bake() {
+        if (layoutChanged) return rebuild();
+
+        int evaluated = 0;
+        for (Item& it : items) {
+            if (!it.dirty) continue;
+            // instances live only in GL memory: rebuild the CPU copy once
+            if (boxes.isExternal()) return rebuild();
+            scratch.clear();
+            it.gen(FurnitureContext{ &scratch });
+            if (it.material.layer >= 0.0f) scratch.setMaterial(0, scratch.size(), it.material);
+            ++evaluated;
+            it.dirty = false;
+
+            // same number of boxes: patch the range in place
+            if (scratch.size() == it.count) {
+                boxes.write(it.first, scratch);
+            }
+            else {
+                // box count changed, lay everything out again
+                return rebuild();
+            }
+        }
+        return evaluated;
+    }
+
+    void draw() { boxes.draw(); }
+
+    // one item on its own (one draw call); for per-item profiling
+    void drawItem(size_t id) { boxes.drawRange(items[id].first, items[id].count); }
+
+private:
+    struct Item {
+        Generator gen;
+        const char* label;    // static string
+        size_t first, count;  // range in boxes
+        BoxMaterial material;
+        bool dirty;
+    };
+
+    std::vector<Item> items;
+    BoxBatch scratch;         // CPU-only, re-evaluation target
+    bool layoutChanged = false;
+
+    int rebuild() {
+        boxes.clear();
+        FurnitureContext ctx{ &boxes };
+        for (Item& it : items) {
+            it.first = boxes.size();
+            it.gen(ctx);
+            it.count = boxes.size() - it.first;
+            if (it.material.layer >= 0.0f) boxes.setMaterial(it.first, it.count, it.material);
+            it.dirty = false;
+        }
+        layoutChanged = false;
+        return (int)items.size();
+    }
+};
@@ -0,0 +1,271 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "GLExt.h"
+#include "GLState.h"
+#include "MeshPool.h"
+#include "RenderStats.h"
+#include "Transform.h"
+
+// What a box samples from the material texture array (TextureArray.h):
+// box-mapped UVs (position on the face in meters, see room.vert) are
+// scaled by uvTransform.xy (repeats a meter), then offset by .zw, and
+// looked up in `layer`; layer -1 is untextured
+struct BoxMaterial {
+    glm::vec4 uvTransform = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+    float layer = -1.0f;
+};
+
+// Collects boxes (walls, furniture parts, lamp marker) and draws them as
+// instances of one indexed mesh (the cube, in a MeshPool) on the cube VAO,
+// normally in a single call. Instances are stored as a
+// structure of arrays, one GL buffer per stream; room.vert reads the model
+// matrix at locations 2..5, the normal matrix at 6..8, the color at 9 and
+// the material (uv transform, layer) at 10 and 11, so textured and plain
+// boxes share the draw. Only instances that changed since the last draw
+// are re-uploaded, so a baked static scene costs no upload at all.
+class BoxBatch {
+public:
+    static const unsigned int kModelLoc = 2;  // mat4 = 4 vec4 slots (2,3,4,5)
+    static const unsigned int kNormalLoc = 6; // mat3 = 3 vec3 slots (6,7,8)
+    static const unsigned int kColorLoc = 9;
+    static const unsigned int kUvLoc = 10;
+    static const unsigned int kLayerLoc = 11;
+
+    // per-instance streams (index i across all of them = one box)
+    std::vector<glm::mat4> models;
+    std::vector<glm::mat3> normals;
+    std::vector<glm::vec3> colors;
+    std::vector<glm::vec4> uvTransforms;
+    std::vector<float> layers;
+
+    BoxBatch() = default;
+    BoxBatch(const BoxBatch&) = delete;
+    BoxBatch& operator=(const BoxBatch&) = delete;
+
+    ~BoxBatch() {
+        if (!modelVBO) return;  // never attached (CPU-only batch)
+        const GLuint vbos[6] = { modelVBO, normalVBO, colorVBO, uvVBO, layerVBO, indirectBuffer };
+        glState().deleteBuffers(6, vbos);
+    }
+
+    // adds the per-instance attributes to an existing VAO (pos at 0, normal
+    // at 1 and the index buffer must already be set up, see MeshPool); the
+    // instances are drawn as `mesh`
+    void attach(unsigned int vao, const Mesh& instanceMesh) {
+        mesh = instanceMesh;
+        if (!modelVBO) glGenBuffers(1, &modelVBO);
+        if (!normalVBO) glGenBuffers(1, &normalVBO);
+        if (!colorVBO) glGenBuffers(1, &colorVBO);
+        if (!uvVBO) glGenBuffers(1, &uvVBO);
+        if (!layerVBO) glGenBuffers(1, &layerVBO);
+
+        glState().bindVertexArray(vao);
+
+        for (unsigned int i = 0; i < 4; ++i) {
+            glEnableVertexAttribArray(kModelLoc + i);
+            glVertexAttribDivisor(kModelLoc + i, 1);
+        }
+        for (unsigned int i = 0; i < 3; ++i) {
+            glEnableVertexAttribArray(kNormalLoc + i);
+            glVertexAttribDivisor(kNormalLoc + i, 1);
+        }
+        for (unsigned int loc : { kColorLoc, kUvLoc, kLayerLoc }) {
+            glEnableVertexAttribArray(loc);
+            glVertexAttribDivisor(loc, 1);
+        }
+        setInstancePointers(0);
+
+        glState().bindVertexArray(0);
+        capacity = 0; // fresh buffers, next draw does a full upload
+    }
+
+    void clear() {
+        models.clear();
+        normals.clear();
+        colors.clear();
+        uvTransforms.clear();
+        layers.clear();
+        dirtyBegin = dirtyEnd = 0;
+        externalCount = 0;
+    }
+
+    void add(const glm::mat4& model, const glm::vec3& color, const BoxMaterial& material = BoxMaterial()) {
+        add(model, normalMatrix(model), color, material);
+    }
+
+    // same, with the normal matrix already known (copying between batches)
+    void add(const glm::mat4& model, const glm::mat3& normal, const glm::vec3& color,
+        const BoxMaterial& material = BoxMaterial()) {
+        models.push_back(model);
+        normals.push_back(normal);
+        colors.push_back(color);
+        uvTransforms.push_back(material.uvTransform);
+        layers.push_back(material.layer);
+        markDirty(size() - 1, size());
+    }
+
+    BoxMaterial material(size_t i) const { return BoxMaterial{ uvTransforms[i], layers[i] }; }
+
+    // re-texture instances [first, first + count); works on external
+    // batches too, whose material streams stay on the CPU
+    void setMaterial(size_t first, size_t count, const BoxMaterial& m) {
+        std::fill(uvTransforms.begin() + first, uvTransforms.begin() + first + count, m.uvTransform);
+        std::fill(layers.begin() + first, layers.begin() + first + count, m.layer);
+        markDirty(first, first + count);
+    }
+
+    // overwrite instances [first, first + src.size()) with src's
+    void write(size_t first, const BoxBatch& src) {
+        std::copy(src.models.begin(), src.models.end(), models.begin() + first);
+        std::copy(src.normals.begin(), src.normals.end(), normals.begin() + first);
+        std::copy(src.colors.begin(), src.colors.end(), colors.begin() + first);
+        std::copy(src.uvTransforms.begin(), src.uvTransforms.end(), uvTransforms.begin() + first);
+        std::copy(src.layers.begin(), src.layers.end(), layers.begin() + first);
+        markDirty(first, first + src.size());
+    }
+
+    // upload instances straight from caller memory (e.g. a memory-mapped
+    // scene file) without copying them into the vectors. They are drawn
+    // until the next clear(); call attach() first. Materials start out
+    // untextured (see setMaterial).
+    void uploadExternal(const glm::mat4* m, const glm::mat3* n, const glm::vec3* c, size_t count) {
+        clear();
+        uvTransforms.assign(count, BoxMaterial().uvTransform);
+        layers.assign(count, BoxMaterial().layer);
+        uploadStream(uvVBO, uvTransforms, count, true, 0, count);
+        uploadStream(layerVBO, layers, count, true, 0, count);
+        glState().bindBuffer(GL_ARRAY_BUFFER, modelVBO);
+        glBufferData(GL_ARRAY_BUFFER, count * sizeof(glm::mat4), m, GL_STATIC_DRAW);
+        glState().bindBuffer(GL_ARRAY_BUFFER, normalVBO);
+        glBufferData(GL_ARRAY_BUFFER, count * sizeof(glm::mat3), n, GL_STATIC_DRAW);
+        glState().bindBuffer(GL_ARRAY_BUFFER, colorVBO);
+        glBufferData(GL_ARRAY_BUFFER, count * sizeof(glm::vec3), c, GL_STATIC_DRAW);
+        externalCount = count;
+        capacity = count;
+    }
+
+    bool isExternal() const { return externalCount != 0; }
+
+    size_t size() const { return externalCount ? externalCount : models.size(); }
+
+    // uploads whatever changed since last time and draws; the attached VAO must be bound
+    void draw() {
+        drawRange(0, size());
+    }
+
+    // draws only instances [first, first + count); attached VAO must be bound
+    void drawRange(size_t first, size_t count) {
+        if (count == 0) return;
+        upload();
+        drawOne(DrawCommand::of(mesh, (GLuint)count, (GLuint)first));
+    }
+
+    // several instance ranges (and meshes) at once; baseInstance indexes
+    // this batch. One glMultiDrawElementsIndirect from a CPU-built command
+    // buffer when the driver has it, else one draw per command
+    void drawCommands(const std::vector<DrawCommand>& cmds) {
+        if (cmds.empty()) return;
+        upload();
+        if (cmds.size() == 1 || !GLExt::multiDrawIndirect) {
+            for (const DrawCommand& c : cmds) drawOne(c);
+            return;
+        }
+
+        if (!indirectBuffer) glGenBuffers(1, &indirectBuffer);
+        glState().bindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, cmds.size() * sizeof(DrawCommand), cmds.data(), GL_STREAM_DRAW);
+        ++renderStats().bufferUploads;
+        // commands carry their own base instance; the pointers start at 0
+        if (pointerBase != 0) setInstancePointers(0);
+        GLExt::MultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, (GLsizei)cmds.size(), 0);
+        ++renderStats().drawCalls;
+        for (const DrawCommand& c : cmds) renderStats().instances += c.instanceCount;
+    }
+
+private:
+    unsigned int modelVBO = 0, normalVBO = 0, colorVBO = 0, uvVBO = 0, layerVBO = 0;
+    unsigned int indirectBuffer = 0;      // drawCommands' command buffer (MDI only)
+    Mesh mesh;                            // what every instance is drawn as
+    size_t externalCount = 0;             // instances uploaded by uploadExternal
+    size_t capacity = 0;                  // instances the GL buffers can hold
+    size_t dirtyBegin = 0, dirtyEnd = 0;  // instance range not yet uploaded
+    size_t pointerBase = 0;               // first instance the attribute pointers start at
+
+    // GL 3.3 has no base instance, so the instance attribute pointers are
+    // re-based to the command's first instance instead
+    void drawOne(const DrawCommand& c) {
+        if (pointerBase != c.baseInstance) setInstancePointers(c.baseInstance);
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, (GLsizei)c.count, GL_UNSIGNED_INT,
+            (void*)(c.firstIndex * sizeof(uint32_t)), (GLsizei)c.instanceCount, c.baseVertex);
+        ++renderStats().drawCalls;
+        renderStats().instances += c.instanceCount;
+    }
+
+    // point the instance attributes of the bound VAO at instance `base`
+    void setInstancePointers(size_t base) {
+        glState().bindBuffer(GL_ARRAY_BUFFER, modelVBO);
+        for (unsigned int i = 0; i < 4; ++i)
+            glVertexAttribPointer(kModelLoc + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                (void*)(base * sizeof(glm::mat4) + i * sizeof(glm::vec4)));
+
+        glState().bindBuffer(GL_ARRAY_BUFFER, normalVBO);
+        for (unsigned int i = 0; i < 3; ++i)
+            glVertexAttribPointer(kNormalLoc + i, 3, GL_FLOAT, GL_FALSE, sizeof(glm::mat3),
+                (void*)(base * sizeof(glm::mat3) + i * sizeof(glm::vec3)));
+
+        glState().bindBuffer(GL_ARRAY_BUFFER, colorVBO);
+        glVertexAttribPointer(kColorLoc, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3),
+            (void*)(base * sizeof(glm::vec3)));
+
+        glState().bindBuffer(GL_ARRAY_BUFFER, uvVBO);
+        glVertexAttribPointer(kUvLoc, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)(base * sizeof(glm::vec4)));
+        glState().bindBuffer(GL_ARRAY_BUFFER, layerVBO);
+        glVertexAttribPointer(kLayerLoc, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)(base * sizeof(float)));
+        pointerBase = base;
+    }
+
+    void markDirty(size_t begin, size_t end) {
+        if (dirtyBegin == dirtyEnd) { dirtyBegin = begin; dirtyEnd = end; return; }
+        dirtyBegin = std::min(dirtyBegin, begin);
+        dirtyEnd = std::max(dirtyEnd, end);
+    }
+
+    template <class T>
+    static void uploadStream(unsigned int vbo, const std::vector<T>& data,
+        size_t capacity, bool realloc, size_t begin, size_t end) {
+        glState().bindBuffer(GL_ARRAY_BUFFER, vbo);
+        if (realloc) {
+            glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(T), nullptr, GL_DYNAMIC_DRAW);
+            begin = 0;
+            end = data.size();
+        }
+        glBufferSubData(GL_ARRAY_BUFFER, begin * sizeof(T), (end - begin) * sizeof(T), data.data() + begin);
+    }
+
+    // external batches only have their material streams to upload (the
+    // rest went up in uploadExternal and never changes)
+    void upload() {
+        bool realloc = size() > capacity;
+        if (!realloc && dirtyBegin == dirtyEnd) return;
+        // grow (x2) so we don't reallocate every time a box is added
+        if (realloc) capacity = size() * 2;
+
+        if (!externalCount) {
+            uploadStream(modelVBO, models, capacity, realloc, dirtyBegin, dirtyEnd);
+            uploadStream(normalVBO, normals, capacity, realloc, dirtyBegin, dirtyEnd);
+            uploadStream(colorVBO, colors, capacity, realloc, dirtyBegin, dirtyEnd);
+            renderStats().bufferUploads += 3;
+        }
+        uploadStream(uvVBO, uvTransforms, capacity, realloc, dirtyBegin, dirtyEnd);
+        uploadStream(layerVBO, layers, capacity, realloc, dirtyBegin, dirtyEnd);
+        dirtyBegin = dirtyEnd = 0;
+        renderStats().bufferUploads += 2;
+    }
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "Frustum.h"
+
+// Bounding-volume hierarchy over the scene's boxes (one world AABB per
+// instance), for frustum culling. Built top-down by median split on the
+// longest centroid axis; every node covers a contiguous range of `items`, so
+// a node entirely inside the frustum emits its range without testing its
+// children.
+class BoxBvh {
+public:
+    static const uint32_t kLeafSize = 4;
+
+    // over instances [0, count)
+    void build(const glm::mat4* models, size_t count) {
+        items.resize(count);
+        for (size_t i = 0; i < count; ++i) items[i] = Item{ boxAabb(models[i]), (uint32_t)i };
+        buildTree();
+    }
+
+    // over a subset of instances (e.g. one room's); cull() reports these ids
+    void build(const glm::mat4* models, const std::vector<uint32_t>& ids) {
+        items.resize(ids.size());
+        for (size_t i = 0; i < ids.size(); ++i) items[i] = Item{ boxAabb(models[ids[i]]), ids[i] };
+        buildTree();
+    }
+
+    size_t size() const { return items.size(); }
+    size_t nodeCount() const { return nodes.size(); }
+
+    // append the indices of every box not outside the frustum
+    void cull(const Frustum& f, std::vector<uint32_t>& visible) const {
+        if (nodes.empty()) return;
+        uint32_t stack[64];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node& n = nodes[stack[--top]];
+            CullResult r = f.test(n.bounds);
+            if (r == CullResult::Outside) continue;
+            if (r == CullResult::Inside) {
+                for (uint32_t i = n.first; i < n.first + n.count; ++i) visible.push_back(items[i].id);
+            }
+            else if (n.child == 0) {
+                for (uint32_t i = n.first; i < n.first + n.count; ++i)
+                    if (f.test(items[i].box) != CullResult::Outside) visible.push_back(items[i].id);
+            }
+            else {
+                stack[top++] = n.child + 1;
+                stack[top++] = n.child;
+            }
+        }
+    }
+
+private:
+    struct Node {
+        Aabb bounds;
+        uint32_t first = 0, count = 0;  // range in items (whole subtree)
+        uint32_t child = 0;             // left child, right = child + 1; 0 = leaf
+    };
+
+    struct Item {
+        Aabb box;
+        uint32_t id;  // instance index
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Item> items;  // grouped by node
+
+    void buildTree() {
+        nodes.clear();
+        if (items.empty()) return;
+        nodes.reserve(2 * items.size() / kLeafSize + 1);
+        nodes.push_back(Node{});
+        buildNode(0, 0, (uint32_t)items.size());
+    }
+
+    void buildNode(uint32_t id, uint32_t first, uint32_t count) {
+        glm::vec3 lo = items[first].box.min(), hi = items[first].box.max();
+        glm::vec3 cLo = items[first].box.center, cHi = cLo;
+        for (uint32_t i = first; i < first + count; ++i) {
+            const Aabb& b = items[i].box;
+            lo = glm::min(lo, b.min()); hi = glm::max(hi, b.max());
+            cLo = glm::min(cLo, b.center); cHi = glm::max(cHi, b.center);
+        }
+        nodes[id].bounds = Aabb::fromMinMax(lo, hi);
+        nodes[id].first = first;
+        nodes[id].count = count;
+        if (count <= kLeafSize) return;
+
+        glm::vec3 span = cHi - cLo;
+        int axis = (span.x > span.y && span.x > span.z) ? 0 : (span.y > span.z ? 1 : 2);
+        uint32_t mid = first + count / 2;
+        std::nth_element(items.begin() + first, items.begin() + mid, items.begin() + first + count,
+            [&](const Item& a, const Item& b) { return a.box.center[axis] < b.box.center[axis]; });
+
+        uint32_t child = (uint32_t)nodes.size();
+        nodes[id].child = child;
+        nodes.push_back(Node{});
+        nodes.push_back(Node{});
+        buildNode(child, first, mid - first);
+        buildNode(child + 1, mid, first + count - mid);
+    }
+};
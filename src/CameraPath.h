@@ -0,0 +1,98 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// same convention as mouse_callback in main.cpp
+inline glm::vec3 frontFromYawPitch(float yawDeg, float pitchDeg) {
+    glm::vec3 f;
+    f.x = std::cos(glm::radians(yawDeg)) * std::cos(glm::radians(pitchDeg));
+    f.y = std::sin(glm::radians(pitchDeg));
+    f.z = std::sin(glm::radians(yawDeg)) * std::cos(glm::radians(pitchDeg));
+    return glm::normalize(f);
+}
+
+// Scripted camera: keyframes (time, position, yaw, pitch), linearly
+// interpolated. Used for headless captures and benchmark playback so runs
+// are repeatable.
+//
+// File format, one keyframe per line ('#' comments):
+//   t  x y z  yawDeg pitchDeg
+class CameraPath {
+public:
+    struct Key {
+        float t;
+        glm::vec3 pos;
+        float yawDeg, pitchDeg;
+    };
+
+    std::vector<Key> keys;
+
+    bool load(const std::string& path, std::string& err) {
+        std::ifstream f(path);
+        if (!f) { err = "cannot open " + path; return false; }
+        keys.clear();
+        std::string line;
+        for (int n = 1; std::getline(f, line); ++n) {
+            size_t hash = line.find('#');
+            if (hash != std::string::npos) line.resize(hash);
+            std::istringstream ss(line);
+            Key k;
+            if (!(ss >> k.t)) continue; // blank line
+            if (!(ss >> k.pos.x >> k.pos.y >> k.pos.z >> k.yawDeg >> k.pitchDeg)) {
+                err = path + ":" + std::to_string(n) + ": expected 't x y z yaw pitch'";
+                return false;
+            }
+            if (!keys.empty() && k.t < keys.back().t) {
+                err = path + ":" + std::to_string(n) + ": keyframe times must increase";
+                return false;
+            }
+            keys.push_back(k);
+        }
+        if (keys.empty()) { err = path + ": no keyframes"; return false; }
+        return true;
+    }
+
+    // slow walk around the default living room, looking at the furniture
+    static CameraPath defaultTour() {
+        CameraPath p;
+        p.keys = {
+            { 0.0f, { 1.5f, 1.4f,  6.0f}, -90.0f,  0.0f },
+            { 2.0f, {-3.0f, 1.6f,  4.0f}, -60.0f, -8.0f },
+            { 4.0f, {-4.0f, 1.2f, -2.0f},   0.0f, -5.0f },
+            { 6.0f, { 0.0f, 2.5f, -5.5f},  90.0f,-20.0f },
+            { 8.0f, { 4.0f, 1.4f,  2.0f}, 200.0f, -5.0f },
+            {10.0f, { 1.5f, 1.4f,  6.0f}, 270.0f,  0.0f },
+        };
+        return p;
+    }
+
+    float duration() const { return keys.empty() ? 0.0f : keys.back().t; }
+
+    // position + front at time t (clamped to the path)
+    void sample(float t, glm::vec3& pos, glm::vec3& front) const {
+        if (keys.empty()) return;
+        if (t <= keys.front().t || keys.size() == 1) { apply(keys.front(), pos, front); return; }
+        if (t >= keys.back().t) { apply(keys.back(), pos, front); return; }
+
+        size_t i = 1;
+        while (keys[i].t < t) ++i;
+        const Key& a = keys[i - 1];
+        const Key& b = keys[i];
+        float s = (b.t > a.t) ? (t - a.t) / (b.t - a.t) : 0.0f;
+
+        Key k{ t, glm::mix(a.pos, b.pos, s), glm::mix(a.yawDeg, b.yawDeg, s), glm::mix(a.pitchDeg, b.pitchDeg, s) };
+        apply(k, pos, front);
+    }
+
+private:
+    static void apply(const Key& k, glm::vec3& pos, glm::vec3& front) {
+        pos = k.pos;
+        front = frontFromYawPitch(k.yawDeg, k.pitchDeg);
+    }
+};
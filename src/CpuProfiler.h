@@ -0,0 +1,185 @@
+#pragma once
+// CPU scope timing, exported as Chrome trace_event JSON (chrome://tracing,
+// Perfetto). Instrument with
+//
+//   PROFILE_SCOPE("glfwSwapBuffers");
+//
+// Every thread records into its own fixed-size ring of events: a write
+// claims the slot (a relaxed store and a release fence), stores the event
+// with relaxed atomics and publishes it with a release store of the head,
+// with no locks and no allocation after the thread's first event. Long
+// sessions keep the newest kCapacity events per thread.
+//
+// PROFILE_SCOPE expands to nothing unless FINALROOM_CPU_PROFILER is 1
+// (cmake -DFINALROOM_CPU_PROFILER=ON), so release builds carry no timers.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#ifndef FINALROOM_CPU_PROFILER
+#define FINALROOM_CPU_PROFILER 0
+#endif
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#if FINALROOM_CPU_PROFILER
+#define PROFILE_SCOPE(name) CpuProfiler::Scope PROFILE_CONCAT(profileScope_, __LINE__)(name)
+#define PROFILE_THREAD(name) CpuProfiler::setThreadName(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#endif
+
+class CpuProfiler {
+public:
+    static const uint64_t kCapacity = 1 << 16;  // events per thread, power of two
+
+    struct Event {
+        const char* name;  // must outlive the export (string literals)
+        uint64_t beginNs, endNs;
+    };
+
+    struct Scope {
+        const char* name;
+        uint64_t begin;
+        explicit Scope(const char* n) : name(n), begin(nowNs()) {}
+        ~Scope() { record(name, begin, nowNs()); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    // nanoseconds since the first call in the process
+    static uint64_t nowNs() {
+        using namespace std::chrono;
+        static const steady_clock::time_point start = steady_clock::now();
+        return (uint64_t)duration_cast<nanoseconds>(steady_clock::now() - start).count();
+    }
+
+    static void record(const char* name, uint64_t beginNs, uint64_t endNs) {
+        ThreadBuffer& t = local();
+        uint64_t i = t.head.load(std::memory_order_relaxed);
+        // seqlock-style: a reader that saw any part of this write also sees
+        // the claim, and drops the slot
+        t.claimed.store(i + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        Slot& s = t.events[i & (kCapacity - 1)];
+        s.name.store(name, std::memory_order_relaxed);
+        s.beginNs.store(beginNs, std::memory_order_relaxed);
+        s.endNs.store(endNs, std::memory_order_relaxed);
+        t.head.store(i + 1, std::memory_order_release);
+    }
+
+    static void setThreadName(const char* name) { local().name.store(name, std::memory_order_relaxed); }
+
+    // Writes every thread's retained events. Safe while other threads keep
+    // recording: events overwritten during the copy are detected through the
+    // claim counter and left out.
+    static void writeChromeTrace(std::ostream& o) {
+        std::vector<std::shared_ptr<ThreadBuffer>> threads;
+        {
+            Registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            threads = r.threads;
+        }
+
+        o << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        bool first = true;
+        char buf[128];
+        std::vector<Event> copy;
+        for (const std::shared_ptr<ThreadBuffer>& t : threads) {
+            const char* tname = t->name.load(std::memory_order_relaxed);
+            std::snprintf(buf, sizeof(buf), "\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", t->id);
+            o << (first ? "" : ",\n") << "{\"name\":\"thread_name\"," << buf;
+            writeString(o, tname ? tname : "thread");
+            o << "}}";
+            first = false;
+
+            uint64_t head = t->head.load(std::memory_order_acquire);
+            uint64_t begin = head > kCapacity ? head - kCapacity : 0;
+            copy.resize((size_t)(head - begin));
+            for (uint64_t i = begin; i < head; ++i) {
+                const Slot& s = t->events[i & (kCapacity - 1)];
+                copy[i - begin] = Event{ s.name.load(std::memory_order_relaxed),
+                    s.beginNs.load(std::memory_order_relaxed), s.endNs.load(std::memory_order_relaxed) };
+            }
+
+            // slot j is rewritten by event j + kCapacity, so everything below
+            // claimed - kCapacity may have been (partly) overwritten meanwhile
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint64_t claimed = t->claimed.load(std::memory_order_relaxed);
+            uint64_t valid = claimed > kCapacity ? claimed - kCapacity : 0;
+            if (valid < begin) valid = begin;
+
+            for (uint64_t i = valid; i < head; ++i) {
+                const Event& e = copy[i - begin];
+                o << ",\n{\"name\":";
+                writeString(o, e.name);
+                std::snprintf(buf, sizeof(buf), ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                    t->id, e.beginNs / 1000.0, (e.endNs - e.beginNs) / 1000.0);
+                o << buf;
+            }
+        }
+        o << "\n]}\n";
+    }
+
+private:
+    // an Event the exporter may read while its thread rewrites it
+    struct Slot {
+        std::atomic<const char*> name;
+        std::atomic<uint64_t> beginNs, endNs;
+    };
+
+    struct ThreadBuffer {
+        std::atomic<uint64_t> head{ 0 };     // events published
+        std::atomic<uint64_t> claimed{ 0 };  // events started (head, or head + 1 mid-write)
+        std::atomic<const char*> name{ nullptr };
+        uint32_t id = 0;
+        std::unique_ptr<Slot[]> events{ new Slot[kCapacity] };
+    };
+
+    // a JSON string literal; names are free text (file names, user labels)
+    static void writeString(std::ostream& o, const char* s) {
+        o << '"';
+        for (; *s; ++s) {
+            const unsigned char c = (unsigned char)*s;
+            if (c == '"' || c == '\\') o << '\\' << (char)c;
+            else if (c < 0x20) {
+                char esc[8];
+                std::snprintf(esc, sizeof(esc), "\\u%04x", (unsigned)c);
+                o << esc;
+            }
+            else o << (char)c;
+        }
+        o << '"';
+    }
+
+    // buffers are shared with the registry so they survive their thread
+    struct Registry {
+        std::mutex mutex;
+        std::vector<std::shared_ptr<ThreadBuffer>> threads;
+    };
+
+    static Registry& registry() {
+        static Registry r;
+        return r;
+    }
+
+    static ThreadBuffer& local() {
+        thread_local std::shared_ptr<ThreadBuffer> buffer = [] {
+            auto b = std::make_shared<ThreadBuffer>();
+            Registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            b->id = (uint32_t)r.threads.size() + 1;
+            r.threads.push_back(b);
+            return b;
+        }();
+        return *buffer;
+    }
+};
@@ -1,85 +1,83 @@
 #include "Cube.h"
-#include "stb_image.h"
+#include "GLState.h"
 
-// positions (x,y,z) and face normals (nx,ny,nz)
-const float Cube::kVertices[36 * 6] = {
+// positions (x,y,z) and face normals (nx,ny,nz); corners counter-clockwise
+// seen from outside
+const float Cube::kVertices[Cube::kVertexCount * 6] = {
     // --- Back face (z = -0.5), normal (0,0,-1)
-    -0.5f,-0.5f,-0.5f,   0.f, 0.f,-1.f,
      0.5f,-0.5f,-0.5f,   0.f, 0.f,-1.f,
-     0.5f, 0.5f,-0.5f,   0.f, 0.f,-1.f,
-     0.5f, 0.5f,-0.5f,   0.f, 0.f,-1.f,
-    -0.5f, 0.5f,-0.5f,   0.f, 0.f,-1.f,
     -0.5f,-0.5f,-0.5f,   0.f, 0.f,-1.f,
+    -0.5f, 0.5f,-0.5f,   0.f, 0.f,-1.f,
+     0.5f, 0.5f,-0.5f,   0.f, 0.f,-1.f,
 
     // --- Front face (z = +0.5), normal (0,0,1)
     -0.5f,-0.5f, 0.5f,   0.f, 0.f, 1.f,
      0.5f,-0.5f, 0.5f,   0.f, 0.f, 1.f,
      0.5f, 0.5f, 0.5f,   0.f, 0.f, 1.f,
-     0.5f, 0.5f, 0.5f,   0.f, 0.f, 1.f,
     -0.5f, 0.5f, 0.5f,   0.f, 0.f, 1.f,
-    -0.5f,-0.5f, 0.5f,   0.f, 0.f, 1.f,
 
     // --- Left face (x = -0.5), normal (-1,0,0)
     -0.5f,-0.5f,-0.5f,  -1.f, 0.f, 0.f,
-    -0.5f, 0.5f,-0.5f,  -1.f, 0.f, 0.f,
-    -0.5f, 0.5f, 0.5f,  -1.f, 0.f, 0.f,
-    -0.5f, 0.5f, 0.5f,  -1.f, 0.f, 0.f,
     -0.5f,-0.5f, 0.5f,  -1.f, 0.f, 0.f,
-    -0.5f,-0.5f,-0.5f,  -1.f, 0.f, 0.f,
+    -0.5f, 0.5f, 0.5f,  -1.f, 0.f, 0.f,
+    -0.5f, 0.5f,-0.5f,  -1.f, 0.f, 0.f,
 
     // --- Right face (x = +0.5), normal (1,0,0)
+     0.5f,-0.5f, 0.5f,   1.f, 0.f, 0.f,
      0.5f,-0.5f,-0.5f,   1.f, 0.f, 0.f,
      0.5f, 0.5f,-0.5f,   1.f, 0.f, 0.f,
      0.5f, 0.5f, 0.5f,   1.f, 0.f, 0.f,
-     0.5f, 0.5f, 0.5f,   1.f, 0.f, 0.f,
-     0.5f,-0.5f, 0.5f,   1.f, 0.f, 0.f,
-     0.5f,-0.5f,-0.5f,   1.f, 0.f, 0.f,
 
-     // --- Bottom face (y = -0.5), normal (0,-1,0)
-     -0.5f,-0.5f,-0.5f,   0.f,-1.f, 0.f,
-      0.5f,-0.5f,-0.5f,   0.f,-1.f, 0.f,
-      0.5f,-0.5f, 0.5f,   0.f,-1.f, 0.f,
-      0.5f,-0.5f, 0.5f,   0.f,-1.f, 0.f,
-     -0.5f,-0.5f, 0.5f,   0.f,-1.f, 0.f,
-     -0.5f,-0.5f,-0.5f,   0.f,-1.f, 0.f,
+    // --- Bottom face (y = -0.5), normal (0,-1,0)
+    -0.5f,-0.5f,-0.5f,   0.f,-1.f, 0.f,
+     0.5f,-0.5f,-0.5f,   0.f,-1.f, 0.f,
+     0.5f,-0.5f, 0.5f,   0.f,-1.f, 0.f,
+    -0.5f,-0.5f, 0.5f,   0.f,-1.f, 0.f,
 
-     // --- Top face (y = +0.5), normal (0,1,0)
-     -0.5f, 0.5f,-0.5f,   0.f, 1.f, 0.f,
-      0.5f, 0.5f,-0.5f,   0.f, 1.f, 0.f,
-      0.5f, 0.5f, 0.5f,   0.f, 1.f, 0.f,
-      0.5f, 0.5f, 0.5f,   0.f, 1.f, 0.f,
-     -0.5f, 0.5f, 0.5f,   0.f, 1.f, 0.f,
-     -0.5f, 0.5f,-0.5f,   0.f, 1.f, 0.f,
+    // --- Top face (y = +0.5), normal (0,1,0)
+    -0.5f, 0.5f, 0.5f,   0.f, 1.f, 0.f,
+     0.5f, 0.5f, 0.5f,   0.f, 1.f, 0.f,
+     0.5f, 0.5f,-0.5f,   0.f, 1.f, 0.f,
+    -0.5f, 0.5f,-0.5f,   0.f, 1.f, 0.f,
+};
+
+// two triangles per face, sharing the 0-2 diagonal
+const uint32_t Cube::kIndices[Cube::kIndexCount] = {
+     0,  1,  2,   2,  3,  0,
+     4,  5,  6,   6,  7,  4,
+     8,  9, 10,  10, 11,  8,
+    12, 13, 14,  14, 15, 12,
+    16, 17, 18,  18, 19, 16,
+    20, 21, 22,  22, 23, 20,
 };
 
 Cube::Cube() {
+    PackedVertex packed[kVertexCount];
+    for (int i = 0; i < kVertexCount; ++i) packed[i] = packVertex(kVertices + i * 6);
+
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
 
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-
-    glBufferData(GL_ARRAY_BUFFER, sizeof(kVertices), kVertices, GL_STATIC_DRAW);
-
-    // position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+    glState().bindVertexArray(VAO);
+    glState().bindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(packed), packed, GL_STATIC_DRAW);
+    setPackedVertexPointers();
 
-    // normal attribute
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float),
-        (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    glState().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(kIndices), kIndices, GL_STATIC_DRAW);
 
-    glBindVertexArray(0);
+    glState().bindVertexArray(0);
 }
 
 Cube::~Cube() {
-    if (VBO) glDeleteBuffers(1, &VBO);
-    if (VAO) glDeleteVertexArrays(1, &VAO);
+    if (EBO) glState().deleteBuffers(1, &EBO);
+    if (VBO) glState().deleteBuffers(1, &VBO);
+    if (VAO) glState().deleteVertexArrays(1, &VAO);
 }
 
+// no unbind afterwards: consecutive cubes keep the VAO bound
 void Cube::Draw() const {
-    glBindVertexArray(VAO);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
+    glState().bindVertexArray(VAO);
+    glDrawElements(GL_TRIANGLES, kIndexCount, GL_UNSIGNED_INT, nullptr);
 }
@@ -2,15 +2,24 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <cstdint>
+
+#include "MeshPool.h"
+
+// The unit cube (-0.5..0.5), indexed: 4 vertices per face so each face keeps
+// its own normal (24), two triangles per face (36 indices). This is the one
+// copy: RoomRenderer adds it to its MeshPool, a Cube object draws it alone.
 class Cube {
 public:
-    unsigned int VAO = 0, VBO = 0;
+    static const int kVertexCount = 24, kIndexCount = 36;
+    static const float kVertices[kVertexCount * 6];   // x y z, nx ny nz
+    static const uint32_t kIndices[kIndexCount];
+
+    static Mesh addTo(MeshPool& pool) { return pool.add(kVertices, kVertexCount, kIndices, kIndexCount); }
+
+    unsigned int VAO = 0, VBO = 0, EBO = 0;
 
     Cube();
     ~Cube();
     void Draw() const;
-
-private:
-    // 36 vertices * (3 position + 3 normal)
-    static const float kVertices[36 * 6];
 };
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstring>
+
+#include "GLExt.h"
+#include "GLState.h"
+#include "RenderStats.h"
+#include "shader.h"   // kFrameUniformsBinding
+
+// CPU mirror of the std140 "FrameUniforms" block in src/frame_uniforms.glsl, which
+// Shader::load pastes into every program that #includes it.
+// Every vec3 is followed by a 4-byte scalar so it fills a full 16-byte slot.
+struct FrameUniformsData {
+    glm::mat4 view;
+    glm::mat4 projection;
+
+    glm::vec3 viewPos;      float ambientScale;     // night mode dims this
+    glm::vec3 lightPos0;    float flashCutoff;      // cos(inner angle)
+    glm::vec3 lightColor0;  float flashOuterCutoff; // cos(outer angle)
+    glm::vec3 lightPos1;    float fogDensity;
+    glm::vec3 lightColor1;  int   useFlashlight;
+    glm::vec3 flashDir;     int   useFog;
+    glm::vec3 flashColor;   float pad0;
+    glm::vec3 fogColor;     float pad1;
+    glm::vec4 clusterScale;  // LightClusters::shaderScale
+};
+
+static_assert(sizeof(FrameUniformsData) == 272, "FrameUniformsData must match std140 layout");
+static_assert(offsetof(FrameUniformsData, viewPos) == 128, "std140 offset");
+static_assert(offsetof(FrameUniformsData, fogColor) == 240, "std140 offset");
+
+// Triple-buffered UBO: frame N writes slot N%3 while the GPU may still be
+// reading the other two. Persistently mapped when ARB_buffer_storage is
+// available, otherwise mapped unsynchronized per frame; fences guard reuse.
+class FrameUniforms {
+public:
+    static const int kSlots = 3;
+
+    FrameUniforms() {
+        GLint align = 256;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &align);
+        slotSize = ((GLsizeiptr)sizeof(FrameUniformsData) + align - 1) / align * align;
+
+        glGenBuffers(1, &ubo);
+        glState().bindBuffer(GL_UNIFORM_BUFFER, ubo);
+        if (GLExt::bufferStorage) {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            GLExt::BufferStorage(GL_UNIFORM_BUFFER, slotSize * kSlots, nullptr, flags);
+            mapped = (char*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, slotSize * kSlots, flags);
+        }
+        else {
+            glBufferData(GL_UNIFORM_BUFFER, slotSize * kSlots, nullptr, GL_DYNAMIC_DRAW);
+        }
+        glState().bindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    ~FrameUniforms() {
+        for (GLsync& f : fences) if (f) glDeleteSync(f);
+        if (mapped) {
+            glState().bindBuffer(GL_UNIFORM_BUFFER, ubo);
+            glUnmapBuffer(GL_UNIFORM_BUFFER);
+        }
+        if (ubo) glState().deleteBuffers(1, &ubo);
+    }
+
+    FrameUniforms(const FrameUniforms&) = delete;
+    FrameUniforms& operator=(const FrameUniforms&) = delete;
+
+    // write this frame's data into the next slot and bind it for every program
+    void update(const FrameUniformsData& data) {
+        slot = (slot + 1) % kSlots;
+        waitSlot(slot);
+
+        GLintptr offset = slot * slotSize;
+        glState().bindBuffer(GL_UNIFORM_BUFFER, ubo);
+        if (mapped) {
+            std::memcpy(mapped + offset, &data, sizeof(data));
+        }
+        else {
+            void* p = glMapBufferRange(GL_UNIFORM_BUFFER, offset, sizeof(data),
+                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+            if (p) {
+                std::memcpy(p, &data, sizeof(data));
+                glUnmapBuffer(GL_UNIFORM_BUFFER);
+            }
+        }
+        glState().bindBufferRange(GL_UNIFORM_BUFFER, kFrameUniformsBinding, ubo, offset, sizeof(data));
+        ++renderStats().bufferUploads;
+    }
+
+    // call after the frame's draws are submitted
+    void endFrame() {
+        if (fences[slot]) glDeleteSync(fences[slot]);
+        fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+private:
+    static constexpr GLuint64 kWaitTimeoutNs = 1000000000ull;   // 1 s
+
+    unsigned int ubo = 0;
+    GLsizeiptr slotSize = 0;
+    char* mapped = nullptr;
+    int slot = 0;
+    GLsync fences[kSlots] = {};
+
+    void waitSlot(int i) {
+        if (!fences[i]) return;
+        // normally already signaled: the GPU is at most two frames behind.
+        // One blocking wait; if that runs out (or fails) something is badly
+        // wrong, and glFinish at least makes overwriting the slot safe.
+        const GLenum r = glClientWaitSync(fences[i], GL_SYNC_FLUSH_COMMANDS_BIT, kWaitTimeoutNs);
+        if (r == GL_TIMEOUT_EXPIRED || r == GL_WAIT_FAILED) glFinish();
+        glDeleteSync(fences[i]);
+        fences[i] = nullptr;
+    }
+};
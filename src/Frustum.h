@@ -0,0 +1,101 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FINALROOM_SSE2 1
+#endif
+
+// Axis-aligned box in center / half-extent form (what the plane test wants).
+struct Aabb {
+    glm::vec3 center = glm::vec3(0.0f);
+    glm::vec3 extent = glm::vec3(0.0f);
+
+    glm::vec3 min() const { return center - extent; }
+    glm::vec3 max() const { return center + extent; }
+
+    static Aabb fromMinMax(const glm::vec3& lo, const glm::vec3& hi) {
+        return Aabb{ (lo + hi) * 0.5f, (hi - lo) * 0.5f };
+    }
+};
+
+// world AABB of the unit cube [-0.5, 0.5]^3 under M (every box is one)
+inline Aabb boxAabb(const glm::mat4& M) {
+    glm::vec3 e = 0.5f * (glm::abs(glm::vec3(M[0])) + glm::abs(glm::vec3(M[1])) + glm::abs(glm::vec3(M[2])));
+    return Aabb{ glm::vec3(M[3]), e };
+}
+
+inline Aabb merge(const Aabb& a, const Aabb& b) {
+    return Aabb::fromMinMax(glm::min(a.min(), b.min()), glm::max(a.max(), b.max()));
+}
+
+enum class CullResult { Outside, Intersect, Inside };
+
+// The six clip planes of a projection * view matrix (Gribb/Hartmann), kept
+// as a structure of arrays padded to eight so the SSE path tests a box
+// against four planes per instruction. Padding planes always pass.
+struct Frustum {
+    alignas(16) float nx[8];
+    alignas(16) float ny[8];
+    alignas(16) float nz[8];
+    alignas(16) float d[8];
+
+    // [x0, x1] x [y0, y1] narrows the side planes to a sub-rectangle of NDC
+    // (a portal's screen bounds); the default is the whole view
+    static Frustum fromMatrix(const glm::mat4& m,
+        float x0 = -1.0f, float y0 = -1.0f, float x1 = 1.0f, float y1 = 1.0f) {
+        Frustum f;
+        auto row = [&](int i) { return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]); };
+        const glm::vec4 planes[6] = {
+            row(0) - x0 * row(3), x1 * row(3) - row(0),  // left, right
+            row(1) - y0 * row(3), y1 * row(3) - row(1),  // bottom, top
+            row(3) + row(2), row(3) - row(2),            // near, far
+        };
+        for (int i = 0; i < 8; ++i) {
+            if (i < 6) {
+                glm::vec4 p = planes[i] / glm::length(glm::vec3(planes[i]));
+                f.nx[i] = p.x; f.ny[i] = p.y; f.nz[i] = p.z; f.d[i] = p.w;
+            }
+            else {
+                f.nx[i] = f.ny[i] = f.nz[i] = 0.0f; f.d[i] = 1.0f;
+            }
+        }
+        return f;
+    }
+
+    CullResult test(const Aabb& b) const {
+#ifdef FINALROOM_SSE2
+        const __m128 cx = _mm_set1_ps(b.center.x), cy = _mm_set1_ps(b.center.y), cz = _mm_set1_ps(b.center.z);
+        const __m128 ex = _mm_set1_ps(b.extent.x), ey = _mm_set1_ps(b.extent.y), ez = _mm_set1_ps(b.extent.z);
+        const __m128 signBit = _mm_set1_ps(-0.0f);
+        int straddle = 0;
+        for (int i = 0; i < 8; i += 4) {
+            __m128 px = _mm_load_ps(nx + i), py = _mm_load_ps(ny + i), pz = _mm_load_ps(nz + i);
+            // signed distance of the center, and the box's projected radius
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, cx), _mm_mul_ps(py, cy)),
+                _mm_add_ps(_mm_mul_ps(pz, cz), _mm_load_ps(d + i)));
+            __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signBit, px), ex),
+                _mm_mul_ps(_mm_andnot_ps(signBit, py), ey)), _mm_mul_ps(_mm_andnot_ps(signBit, pz), ez));
+            if (_mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(dist, r), _mm_setzero_ps()))) return CullResult::Outside;
+            straddle |= _mm_movemask_ps(_mm_cmplt_ps(dist, r));
+        }
+        return straddle ? CullResult::Intersect : CullResult::Inside;
+#else
+        return testScalar(b);
+#endif
+    }
+
+    CullResult testScalar(const Aabb& b) const {
+        bool straddle = false;
+        for (int i = 0; i < 6; ++i) {
+            float dist = nx[i] * b.center.x + ny[i] * b.center.y + nz[i] * b.center.z + d[i];
+            float r = std::fabs(nx[i]) * b.extent.x + std::fabs(ny[i]) * b.extent.y + std::fabs(nz[i]) * b.extent.z;
+            if (dist + r < 0.0f) return CullResult::Outside;
+            if (dist < r) straddle = true;
+        }
+        return straddle ? CullResult::Intersect : CullResult::Inside;
+    }
+};
@@ -4,9 +4,8 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-#include "shader.h"
-
-glm::vec3 hexColor(unsigned int hex);
+#include "BoxBatch.h"
+#include "CpuProfiler.h"
 
 inline glm::vec3 hexRGB(unsigned int hex) {
     float r = ((hex >> 16) & 0xFF) / 255.0f;
@@ -15,14 +14,16 @@ inline glm::vec3 hexRGB(unsigned int hex) {
     return glm::vec3(r, g, b);
 }
 
+// 0xRRGGBB -> glm::vec3
+inline glm::vec3 hexColor(unsigned int hex) { return hexRGB(hex); }
+
 
 struct FurnitureContext {
-    unsigned int cubeVAO; // bound cube VBO/VAO with 36 verts, pos+normal
-    Shader* shader;       // active shader (has 'model' and 'objectColor')
+    BoxBatch* batch;      // every box is queued here, drawn instanced in one call
 };
 
-inline void setModel(Shader& sh, const glm::mat4& M) {
-    sh.setMat4("model", M);
+inline void emitBox(const FurnitureContext& ctx, const glm::mat4& M, const glm::vec3& color) {
+    ctx.batch->add(M, color);
 }
 
 // ---------------- Coffee Table ----------------
@@ -31,9 +32,7 @@ inline void drawCoffeeTable(const FurnitureContext& ctx,
     float rotateYdeg = 0.0f,
     const glm::vec3& globalScale = glm::vec3(1.0f))
 {
-    Shader& shader = *ctx.shader;
-    glBindVertexArray(ctx.cubeVAO);
-
+    PROFILE_SCOPE("drawCoffeeTable");
     // --- component sizes (in local space) ---
     glm::vec3 topScale = glm::vec3(2.0f, 0.15f, 1.2f);
     glm::vec3 legScale = glm::vec3(0.15f, 0.50f, 0.15f);
@@ -61,9 +60,7 @@ inline void drawCoffeeTable(const FurnitureContext& ctx,
         glm::mat4 model = M;
         model = glm::translate(model, topPos);
         model = glm::scale(model, topScale);
-        shader.setMat4("model", model);
-        shader.setVec3("objectColor", topColor);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+        emitBox(ctx, model, topColor);
     }
 
     // four legs (offsets from local center)
@@ -80,18 +77,14 @@ inline void drawCoffeeTable(const FurnitureContext& ctx,
         glm::mat4 model = M;
         model = glm::translate(model, legCenter + legOffsets[i]);
         model = glm::scale(model, legScale);
-        shader.setMat4("model", model);
-        shader.setVec3("objectColor", legColor);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+        emitBox(ctx, model, legColor);
     }
 }
 
 // ---------------- TV Stand ----------------
 inline void drawTVStand(const FurnitureContext& ctx,
     const glm::vec3& bodyPos = glm::vec3(0.0f, 0.50f, -2.2f)) {
-        Shader& shader = *ctx.shader;
-        glBindVertexArray(ctx.cubeVAO);
-
+        PROFILE_SCOPE("drawTVStand");
         glm::vec3 bodySize(1.6f, 0.50f, 0.50f);
         int shelves = 2;
         float shelfT = 0.04f;
@@ -118,9 +111,7 @@ inline void drawTVStand(const FurnitureContext& ctx,
             glm::mat4 M(1.0f);
             M = glm::translate(M, c);
             M = glm::scale(M, glm::vec3(legT, legH, legT));
-            setModel(shader, M);
-            shader.setVec3("objectColor", legColor);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+            emitBox(ctx, M, legColor);
         }
     }
 
@@ -129,9 +120,7 @@ inline void drawTVStand(const FurnitureContext& ctx,
         glm::mat4 M(1.0f);
         M = glm::translate(M, bodyPos);
         M = glm::scale(M, bodySize);
-        setModel(shader, M);
-        shader.setVec3("objectColor", bodyColor);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+        emitBox(ctx, M, bodyColor);
     }
 
     // shelves
@@ -142,9 +131,7 @@ inline void drawTVStand(const FurnitureContext& ctx,
         glm::mat4 M(1.0f);
         M = glm::translate(M, glm::vec3(bodyPos.x, y, bodyPos.z));
         M = glm::scale(M, glm::vec3(bodySize.x * 0.95f, shelfT, bodySize.z * 0.95f));
-        setModel(shader, M);
-        shader.setVec3("objectColor", shelfColor);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+        emitBox(ctx, M, shelfColor);
     }
 }
 
@@ -153,9 +140,7 @@ inline void drawSofa(const FurnitureContext& ctx,
     const glm::vec3& pos,    // world position of sofa center
     float yawDeg)            // rotate around Y so it faces table
 {
-    Shader& shader = *ctx.shader;
-    glBindVertexArray(ctx.cubeVAO);
-
+    PROFILE_SCOPE("drawSofa");
     // Colors
     glm::vec3 seatCol = hexColor(0x3E5F8A);
     glm::vec3 sideCol = hexColor(0x23374F);
@@ -170,9 +155,7 @@ inline void drawSofa(const FurnitureContext& ctx,
             glm::mat4 M = T * R;
             M = glm::translate(M, localPos);
             M = glm::scale(M, scale);
-            shader.setMat4("model", M);
-            shader.setVec3("objectColor", color);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+            emitBox(ctx, M, color);
         };
 
     // Dimensions (units match your room)
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "GLState.h"
+
+// Geometry buffer for the deferred path: albedo (RGBA8), world normal
+// (RGB10_A2, stored as n * 0.5 + 0.5) and depth (24-bit texture, so the
+// lighting pass can rebuild positions). Reallocated when the size changes.
+class GBuffer {
+public:
+    int width = 0, height = 0;
+
+    GBuffer() = default;
+    ~GBuffer() { release(); }
+    GBuffer(const GBuffer&) = delete;
+    GBuffer& operator=(const GBuffer&) = delete;
+
+    bool ok() const { return complete; }
+
+    void resize(int w, int h) {
+        if (fbo && w == width && h == height) return;
+        release();
+        width = w;
+        height = h;
+
+        glGenFramebuffers(1, &fbo);
+        glGenTextures(3, textures);
+        const GLenum internal[3] = { GL_RGBA8, GL_RGB10_A2, GL_DEPTH_COMPONENT24 };
+        const GLenum format[3] = { GL_RGBA, GL_RGBA, GL_DEPTH_COMPONENT };
+        const GLenum type[3] = { GL_UNSIGNED_BYTE, GL_UNSIGNED_INT_2_10_10_10_REV, GL_UNSIGNED_INT };
+        for (int i = 0; i < 3; ++i) {
+            glState().bindTexture(0, GL_TEXTURE_2D, textures[i]);
+            glTexImage2D(GL_TEXTURE_2D, 0, internal[i], w, h, 0, format[i], type[i], nullptr);
+            // read with texelFetch only
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        }
+        glState().bindTexture(0, GL_TEXTURE_2D, 0);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[0], 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, textures[1], 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[2], 0);
+        const GLenum buffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+        glDrawBuffers(2, buffers);
+        complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    void bind() const { glBindFramebuffer(GL_FRAMEBUFFER, fbo); }
+
+    // albedo, normal, depth on texture units unit, unit + 1, unit + 2
+    void bindTextures(GLuint unit) const {
+        for (int i = 0; i < 3; ++i) glState().bindTexture(unit + i, GL_TEXTURE_2D, textures[i]);
+    }
+
+private:
+    GLuint fbo = 0;
+    GLuint textures[3] = {};
+    bool complete = false;
+
+    void release() {
+        if (!fbo) return;
+        glState().deleteTextures(3, textures);
+        glDeleteFramebuffers(1, &fbo);
+        fbo = 0;
+        complete = false;
+    }
+};
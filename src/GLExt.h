@@ -0,0 +1,125 @@
+#pragma once
+// Optional entry points above our GL 3.3 core baseline. glad only loads
+// 3.3, so anything newer is looked up here once after gladLoadGLLoader and
+// used only when the driver reports it (callers keep a 3.3 fallback).
+
+#include <glad/glad.h>
+
+#include <cstring>
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+// ARB_get_program_binary
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+// KHR_parallel_shader_compile
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+typedef void (APIENTRYP PFN_glBufferStorage)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+typedef void (APIENTRYP PFN_glMultiDrawElementsIndirect)(GLenum mode, GLenum type, const void* indirect,
+    GLsizei drawcount, GLsizei stride);
+typedef void (APIENTRYP PFN_glGetProgramBinary)(GLuint program, GLsizei bufSize, GLsizei* length,
+    GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP PFN_glProgramBinary)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFN_glProgramParameteri)(GLuint program, GLenum pname, GLint value);
+typedef void (APIENTRYP PFN_glMaxShaderCompilerThreads)(GLuint count);
+
+struct GLExt {
+    static inline int major = 3, minor = 3;
+
+    // GL 4.4 / ARB_buffer_storage (persistent mapped buffers)
+    static inline bool bufferStorage = false;
+    static inline PFN_glBufferStorage BufferStorage = nullptr;
+
+    // GL 4.3 / ARB_multi_draw_indirect, with baseInstance honoured (4.2 /
+    // ARB_base_instance) so one command can start mid instance stream
+    static inline bool multiDrawIndirect = false;
+    static inline PFN_glMultiDrawElementsIndirect MultiDrawElementsIndirect = nullptr;
+
+    // EXT_texture_compression_s3tc: BC1 / BC3 textures (every desktop
+    // driver has it, but it never made it into core)
+    static inline bool s3tc = false;
+
+    // GL 4.1 / ARB_get_program_binary, and the driver offers at least one
+    // binary format (ShaderCache)
+    static inline bool programBinary = false;
+    static inline PFN_glGetProgramBinary GetProgramBinary = nullptr;
+    static inline PFN_glProgramBinary ProgramBinary = nullptr;
+    static inline PFN_glProgramParameteri ProgramParameteri = nullptr;
+
+    // KHR_parallel_shader_compile (or the ARB one): compiles and links run
+    // on driver threads and GL_COMPLETION_STATUS_KHR can be polled
+    static inline bool parallelShaderCompile = false;
+    static inline PFN_glMaxShaderCompilerThreads MaxShaderCompilerThreads = nullptr;
+
+    static bool version(int maj, int min) {
+        return major > maj || (major == maj && minor >= min);
+    }
+
+    static bool has(const char* name) {
+        GLint n = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &n);
+        for (GLint i = 0; i < n; ++i) {
+            const char* ext = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+            if (ext && std::strcmp(ext, name) == 0) return true;
+        }
+        return false;
+    }
+
+    static void load(GLADloadproc loader) {
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+
+        if (version(4, 4) || has("GL_ARB_buffer_storage")) {
+            BufferStorage = (PFN_glBufferStorage)loader("glBufferStorage");
+            bufferStorage = BufferStorage != nullptr;
+        }
+        if (version(4, 3) || (has("GL_ARB_multi_draw_indirect") && (version(4, 2) || has("GL_ARB_base_instance")))) {
+            MultiDrawElementsIndirect = (PFN_glMultiDrawElementsIndirect)loader("glMultiDrawElementsIndirect");
+            multiDrawIndirect = MultiDrawElementsIndirect != nullptr;
+        }
+        s3tc = has("GL_EXT_texture_compression_s3tc");
+
+        if (version(4, 1) || has("GL_ARB_get_program_binary")) {
+            GetProgramBinary = (PFN_glGetProgramBinary)loader("glGetProgramBinary");
+            ProgramBinary = (PFN_glProgramBinary)loader("glProgramBinary");
+            ProgramParameteri = (PFN_glProgramParameteri)loader("glProgramParameteri");
+            GLint formats = 0;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+            programBinary = GetProgramBinary && ProgramBinary && ProgramParameteri && formats > 0;
+        }
+        if (has("GL_KHR_parallel_shader_compile"))
+            MaxShaderCompilerThreads = (PFN_glMaxShaderCompilerThreads)loader("glMaxShaderCompilerThreadsKHR");
+        else if (has("GL_ARB_parallel_shader_compile"))
+            MaxShaderCompilerThreads = (PFN_glMaxShaderCompilerThreads)loader("glMaxShaderCompilerThreadsARB");
+        parallelShaderCompile = MaxShaderCompilerThreads != nullptr;
+        // let the driver pick how many threads (0xFFFFFFFF = implementation maximum)
+        if (parallelShaderCompile) MaxShaderCompilerThreads(0xFFFFFFFFu);
+    }
+};
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "GLExt.h"   // GL_DRAW_INDIRECT_BUFFER
+#include "RenderStats.h"
+
+// Shadow of the GL binding / fixed-function state the renderer touches
+// (program, VAO, buffer targets, textures per unit, depth / cull / scissor
+// enables, depth func and mask, color mask). Every call compares against
+// the shadow and only reaches the driver when something changes; both
+// outcomes are counted in RenderStats (stateCalls / stateSkipped).
+//
+// Only correct if everything goes through it: code that binds behind its
+// back must call invalidate() afterwards. Deleting a bound object unbinds
+// it in GL, so deletes go through here too. One context per process.
+class GLState {
+public:
+    static const int kTextureUnits = 16;
+
+    GLState() { invalidate(); }
+
+    // forget everything; the next call of each kind always reaches GL
+    void invalidate() {
+        program = vao = kUnknown;
+        for (GLuint& b : buffers) b = kUnknown;
+        elementBuffer = kUnknown;
+        activeUnit = kUnknown;
+        for (auto& unit : textures)
+            for (GLuint& t : unit) t = kUnknown;
+        for (int& c : caps) c = -1;
+        depthFn = kUnknown;
+        depthWrite = colorWrite = -1;
+    }
+
+    void useProgram(GLuint p) {
+        if (!changed(program, p)) return;
+        glUseProgram(p);
+    }
+
+    // the element buffer belongs to the VAO, so it is unknown after a switch
+    void bindVertexArray(GLuint v) {
+        if (!changed(vao, v)) return;
+        glBindVertexArray(v);
+        elementBuffer = kUnknown;
+    }
+
+    void bindBuffer(GLenum target, GLuint b) {
+        GLuint* slot = bufferSlot(target);
+        if (slot && !changed(*slot, b)) return;
+        if (!slot) ++renderStats().stateCalls;
+        glBindBuffer(target, b);
+    }
+
+    // also binds the buffer to the generic target, like GL does
+    void bindBufferRange(GLenum target, GLuint index, GLuint b, GLintptr offset, GLsizeiptr size) {
+        ++renderStats().stateCalls;
+        glBindBufferRange(target, index, b, offset, size);
+        if (GLuint* slot = bufferSlot(target)) *slot = b;
+    }
+
+    // binds on `unit` and leaves it the active unit, so glTex* calls right
+    // after edit `t` even when the bind itself was skipped
+    void bindTexture(GLuint unit, GLenum target, GLuint t) {
+        activeTexture(unit);
+        int ti = textureSlot(target);
+        if (unit >= (GLuint)kTextureUnits || ti < 0) {
+            ++renderStats().stateCalls;
+            glBindTexture(target, t);
+            return;
+        }
+        if (!changed(textures[unit][ti], t)) return;
+        glBindTexture(target, t);
+    }
+
+    void enable(GLenum cap, bool on) {
+        int ci = capSlot(cap);
+        if (ci >= 0) {
+            if (caps[ci] == (int)on) { ++renderStats().stateSkipped; return; }
+            caps[ci] = on;
+        }
+        ++renderStats().stateCalls;
+        if (on) glEnable(cap);
+        else glDisable(cap);
+    }
+
+    void depthFunc(GLenum fn) {
+        if (!changed(depthFn, fn)) return;
+        glDepthFunc(fn);
+    }
+
+    void depthMask(bool on) {
+        if (depthWrite == (int)on) { ++renderStats().stateSkipped; return; }
+        depthWrite = on;
+        ++renderStats().stateCalls;
+        glDepthMask(on ? GL_TRUE : GL_FALSE);
+    }
+
+    // all four channels at once, which is all the renderer needs
+    void colorMask(bool on) {
+        if (colorWrite == (int)on) { ++renderStats().stateSkipped; return; }
+        colorWrite = on;
+        ++renderStats().stateCalls;
+        GLboolean b = on ? GL_TRUE : GL_FALSE;
+        glColorMask(b, b, b, b);
+    }
+
+    // deleting unbinds in GL: drop the names from the shadow first
+    void deleteProgram(GLuint p) {
+        if (program == p) program = kUnknown;
+        glDeleteProgram(p);
+    }
+
+    void deleteVertexArrays(GLsizei n, const GLuint* v) {
+        for (GLsizei i = 0; i < n; ++i)
+            if (v[i] && vao == v[i]) vao = elementBuffer = kUnknown;
+        glDeleteVertexArrays(n, v);
+    }
+
+    void deleteBuffers(GLsizei n, const GLuint* b) {
+        for (GLsizei i = 0; i < n; ++i) {
+            if (!b[i]) continue;
+            for (GLuint& slot : buffers) if (slot == b[i]) slot = kUnknown;
+            if (elementBuffer == b[i]) elementBuffer = kUnknown;
+        }
+        glDeleteBuffers(n, b);
+    }
+
+    void deleteTextures(GLsizei n, const GLuint* t) {
+        for (GLsizei i = 0; i < n; ++i) {
+            if (!t[i]) continue;
+            for (auto& unit : textures)
+                for (GLuint& slot : unit) if (slot == t[i]) slot = kUnknown;
+        }
+        glDeleteTextures(n, t);
+    }
+
+private:
+    static const GLuint kUnknown = 0xFFFFFFFFu;  // never a GL name or enum we use
+
+    // ARRAY, UNIFORM, TEXTURE, PIXEL_PACK, PIXEL_UNPACK, DRAW_INDIRECT
+    GLuint buffers[6];
+    GLuint elementBuffer;
+    GLuint program, vao;
+    GLuint activeUnit;
+    GLuint textures[kTextureUnits][3];  // 2D, BUFFER, 2D_ARRAY
+    int caps[3];                        // DEPTH_TEST, CULL_FACE, SCISSOR_TEST (-1 unknown)
+    GLuint depthFn;
+    int depthWrite, colorWrite;
+
+    // counts the call either way; true if GL needs to hear about it
+    static bool changed(GLuint& shadow, GLuint value) {
+        if (shadow == value) { ++renderStats().stateSkipped; return false; }
+        shadow = value;
+        ++renderStats().stateCalls;
+        return true;
+    }
+
+    void activeTexture(GLuint unit) {
+        if (!changed(activeUnit, unit)) return;
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+
+    GLuint* bufferSlot(GLenum target) {
+        switch (target) {
+        case GL_ARRAY_BUFFER: return &buffers[0];
+        case GL_UNIFORM_BUFFER: return &buffers[1];
+        case GL_TEXTURE_BUFFER: return &buffers[2];
+        case GL_PIXEL_PACK_BUFFER: return &buffers[3];
+        case GL_PIXEL_UNPACK_BUFFER: return &buffers[4];
+        case GL_DRAW_INDIRECT_BUFFER: return &buffers[5];
+        case GL_ELEMENT_ARRAY_BUFFER: return &elementBuffer;
+        default: return nullptr;
+        }
+    }
+
+    static int textureSlot(GLenum target) {
+        switch (target) {
+        case GL_TEXTURE_2D: return 0;
+        case GL_TEXTURE_BUFFER: return 1;
+        case GL_TEXTURE_2D_ARRAY: return 2;
+        default: return -1;
+        }
+    }
+
+    static int capSlot(GLenum cap) {
+        switch (cap) {
+        case GL_DEPTH_TEST: return 0;
+        case GL_CULL_FACE: return 1;
+        case GL_SCISSOR_TEST: return 2;
+        default: return -1;
+        }
+    }
+};
+
+inline GLState& glState() {
+    static GLState state;
+    return state;
+}
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "GLState.h"
+#include "JsonString.h"
+
+// Per-pass GPU timing with GL_TIME_ELAPSED queries. Each frame issues one
+// query per pass into one of two query sets; the set of frame N-1 is read
+// at the end of frame N, when the GPU has normally finished it, so reading
+// never stalls. If a result is still not available the frame is dropped
+// instead of waited on. Passes with the same name in one frame are summed.
+//
+// Elapsed-time queries can't nest, so passes are flat: begin() closes the
+// open pass first.
+//
+//   profiler.beginFrame();
+//   { GpuProfiler::Scope p(&profiler, "scene"); ... }
+//   profiler.endFrame();
+class GpuProfiler {
+public:
+    static const int kSets = 2;
+
+    struct Pass {
+        std::string name;
+        double ms = 0.0;     // last completed frame
+        double avgMs = 0.0;  // exponential moving average
+    };
+
+    // RAII pass; a null profiler makes it a no-op
+    struct Scope {
+        GpuProfiler* p;
+        Scope(GpuProfiler* prof, const char* name) : p(prof) { if (p) p->begin(name); }
+        ~Scope() { if (p) p->end(); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    bool enabled = true;
+    bool splitPasses = false;  // renderers draw each scene item as its own pass
+    bool recording = false;    // keep every frame's times for writeCsv/writeJson
+
+    GpuProfiler() = default;
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+    ~GpuProfiler() {
+        for (std::vector<GLuint>& q : queries)
+            if (!q.empty()) glDeleteQueries((GLsizei)q.size(), q.data());
+    }
+
+    void beginFrame() {
+        cur = (int)(frame % kSets);
+        issued[cur].clear();
+    }
+
+    void begin(const char* name) {
+        if (!enabled) return;
+        if (open) end();
+        size_t n = issued[cur].size();
+        if (n == queries[cur].size()) {
+            queries[cur].push_back(0);
+            glGenQueries(1, &queries[cur].back());
+        }
+        issued[cur].push_back(passIndex(name));
+        glBeginQuery(GL_TIME_ELAPSED, queries[cur][n]);
+        open = true;
+    }
+
+    void end() {
+        if (!open) return;
+        glEndQuery(GL_TIME_ELAPSED);
+        open = false;
+    }
+
+    void endFrame() {
+        end();
+        if (frame > 0) collect((int)((frame - 1) % kSets), frame - 1);
+        ++frame;
+    }
+
+    const std::vector<Pass>& passes() const { return passList; }
+    size_t droppedFrames() const { return dropped; }
+
+    double totalMs() const {
+        double t = 0.0;
+        for (const Pass& p : passList) t += p.ms;
+        return t;
+    }
+
+    // "clear 0.02 | scene 0.81 | ..." (averages) for a window title or log
+    std::string summary() const {
+        std::string s;
+        char ms[32];
+        for (const Pass& p : passList) {
+            std::snprintf(ms, sizeof(ms), " %.2f", p.avgMs);
+            if (!s.empty()) s += " | ";
+            s += p.name;
+            s += ms;
+        }
+        return s + " ms";
+    }
+
+    // Bar per pass in the top-left corner, full width = budgetMs. Drawn with
+    // scissored clears, so it needs no shader and touches no other state.
+    void drawOverlay(int width, int height, double budgetMs = 1000.0 / 60.0) const {
+        static const float palette[][3] = {
+            { 0.90f, 0.30f, 0.25f }, { 0.30f, 0.75f, 0.35f }, { 0.25f, 0.50f, 0.95f },
+            { 0.95f, 0.80f, 0.20f }, { 0.70f, 0.35f, 0.90f }, { 0.20f, 0.85f, 0.85f },
+        };
+        const int rowH = 6, gap = 2, margin = 8;
+        const int fullW = width / 3;
+
+        GLfloat clearCol[4];
+        glGetFloatv(GL_COLOR_CLEAR_VALUE, clearCol);
+        glState().enable(GL_SCISSOR_TEST, true);
+
+        int y = height - margin;
+        for (size_t i = 0; i < passList.size() && y - rowH > 0; ++i) {
+            y -= rowH;
+            glScissor(margin, y, fullW, rowH);
+            glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            int w = (int)(fullW * passList[i].avgMs / budgetMs);
+            if (w > fullW) w = fullW;
+            if (w > 0) {
+                const float* c = palette[i % (sizeof(palette) / sizeof(palette[0]))];
+                glScissor(margin, y, w, rowH);
+                glClearColor(c[0], c[1], c[2], 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT);
+            }
+            y -= gap;
+        }
+
+        glState().enable(GL_SCISSOR_TEST, false);
+        glClearColor(clearCol[0], clearCol[1], clearCol[2], clearCol[3]);
+    }
+
+    // one row per recorded frame, one column per pass (ms)
+    void writeCsv(std::ostream& o) const {
+        o << "frame";
+        for (const Pass& p : passList) o << "," << csvField(p.name);
+        o << "\n";
+        for (const Frame& f : history) {
+            o << f.index;
+            for (size_t i = 0; i < passList.size(); ++i) o << "," << (i < f.ms.size() ? f.ms[i] : 0.0);
+            o << "\n";
+        }
+    }
+
+    void writeJson(std::ostream& o) const {
+        o << "{\n  \"passes\": [";
+        for (size_t i = 0; i < passList.size(); ++i)
+            o << (i ? ", " : "") << "\"" << jsonEscape(passList[i].name) << "\"";
+        o << "],\n  \"average_ms\": {";
+        for (size_t i = 0; i < passList.size(); ++i)
+            o << (i ? ", " : " ") << "\"" << jsonEscape(passList[i].name) << "\": " << passList[i].avgMs;
+        o << " },\n  \"dropped_frames\": " << dropped << ",\n  \"frames\": [\n";
+        for (size_t r = 0; r < history.size(); ++r) {
+            o << "    { \"frame\": " << history[r].index << ", \"ms\": [";
+            for (size_t i = 0; i < passList.size(); ++i)
+                o << (i ? ", " : "") << (i < history[r].ms.size() ? history[r].ms[i] : 0.0);
+            o << "] }" << (r + 1 < history.size() ? "," : "") << "\n";
+        }
+        o << "  ]\n}\n";
+    }
+
+private:
+    // pass names are scene item labels with splitPasses: quoted (RFC 4180)
+    // when they hold a separator, a quote or a line break
+    static std::string csvField(const std::string& s) {
+        if (s.find_first_of(",\"\r\n") == std::string::npos) return s;
+        std::string out = "\"";
+        for (char c : s) {
+            if (c == '"') out += '"';
+            out += c;
+        }
+        return out + "\"";
+    }
+
+    struct Frame {
+        unsigned long long index;
+        std::vector<double> ms;  // by pass index
+    };
+
+    std::vector<GLuint> queries[kSets];  // grown on demand, reused every other frame
+    std::vector<int> issued[kSets];      // pass index of each query issued this frame
+    std::vector<Pass> passList;          // by name, so bars and columns keep their place
+    std::vector<Frame> history;
+    unsigned long long frame = 0;
+    size_t dropped = 0;
+    int cur = 0;
+    bool open = false;
+
+    int passIndex(const char* name) {
+        size_t pos = 0;
+        while (pos < passList.size() && passList[pos].name < name) ++pos;
+        if (pos < passList.size() && passList[pos].name == name) return (int)pos;
+
+        // a new name: insert it in order and shift what refers past it
+        passList.insert(passList.begin() + pos, Pass{ name });
+        for (std::vector<int>& set : issued)
+            for (int& i : set)
+                if (i >= (int)pos) ++i;
+        for (Frame& f : history)
+            if (pos <= f.ms.size()) f.ms.insert(f.ms.begin() + pos, 0.0);
+        return (int)pos;
+    }
+
+    void collect(int set, unsigned long long index) {
+        const std::vector<int>& pass = issued[set];
+        if (pass.empty()) return;
+
+        // queries complete in order: if the last one is done, all are
+        GLint ready = 0;
+        glGetQueryObjectiv(queries[set][pass.size() - 1], GL_QUERY_RESULT_AVAILABLE, &ready);
+        if (!ready) { ++dropped; return; }
+
+        std::vector<double> ms(passList.size(), 0.0);
+        for (size_t i = 0; i < pass.size(); ++i) {
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(queries[set][i], GL_QUERY_RESULT, &ns);
+            ms[pass[i]] += ns / 1.0e6;
+        }
+        for (size_t i = 0; i < passList.size(); ++i) {
+            Pass& p = passList[i];
+            p.avgMs = (p.ms == 0.0 && p.avgMs == 0.0) ? ms[i] : p.avgMs * 0.9 + ms[i] * 0.1;
+            p.ms = ms[i];
+        }
+        if (recording) history.push_back(Frame{ index, std::move(ms) });
+    }
+};
@@ -0,0 +1,107 @@
+#include "Headless.h"
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "CameraPath.h"
+#include "GLExt.h"
+#include "GLState.h"
+#include "Offscreen.h"
+#include "RoomRenderer.h"
+
+// hidden 3.3 core window that only provides the context
+static GLFWwindow* createHiddenWindow(int w, int h) {
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    return glfwCreateWindow(w, h, "FinalRoom (headless)", nullptr, nullptr);
+}
+
+int runHeadless(const HeadlessOptions& opt) {
+    // try the normal platform first (X11/Wayland/Xvfb), then GLFW's null
+    // platform (3.4+) which needs no display server at all (EGL/OSMesa context)
+    GLFWwindow* window = nullptr;
+    if (glfwInit()) window = createHiddenWindow(opt.width, opt.height);
+#ifdef GLFW_PLATFORM_NULL
+    if (!window) {
+        glfwTerminate();
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+        if (glfwInit()) window = createHiddenWindow(opt.width, opt.height);
+    }
+#endif
+    if (!window) { std::cerr << "Headless: no GL context available\n"; glfwTerminate(); return 1; }
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        std::cerr << "GLAD init failed\n"; glfwTerminate(); return 1;
+    }
+    GLExt::load((GLADloadproc)glfwGetProcAddress);
+    glState().enable(GL_DEPTH_TEST, true);
+    glState().enable(GL_CULL_FACE, false);
+
+    CameraPath path = CameraPath::defaultTour();
+    std::string err;
+    if (!opt.cameraPath.empty() && !path.load(opt.cameraPath, err)) {
+        std::cerr << err << "\n"; glfwTerminate(); return 1;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(opt.outDir, ec);
+
+    int rc = 0;
+    {
+        // GL objects must go before glfwTerminate
+        RoomRenderer renderer;
+        OffscreenTarget target(opt.width, opt.height);
+
+        if (!renderer.loadScene(opt.scenePath, err)) {
+            std::cerr << "Scene load failed: " << err << "\n";
+            rc = 1;
+        }
+        else if (!target.ok()) {
+            std::cerr << "Headless: framebuffer incomplete\n";
+            rc = 1;
+        }
+        else {
+            renderer.textures.finish();   // every frame with the materials in
+            std::vector<unsigned char> pixels;
+            auto save = [&](int frame) {
+                char name[32];
+                std::snprintf(name, sizeof(name), "frame_%05d.ppm", frame);
+                std::string file = (std::filesystem::path(opt.outDir) / name).string();
+                if (!target.endRead(frame, pixels) || !writePPM(file, pixels, target.width, target.height)) {
+                    std::cerr << "Headless: cannot write " << file << "\n";
+                    rc = 1;
+                }
+            };
+
+            ViewState view;
+            for (int i = 0; i < opt.frames; ++i) {
+                float t = opt.frames > 1 ? path.duration() * i / float(opt.frames - 1) : 0.0f;
+                path.sample(t, view.camPos, view.camFront);
+
+                target.bind();
+                renderer.renderFrame(view, target.width, target.height);
+                renderer.endFrame();
+                target.beginRead(i);
+
+                // previous frame's pixels are ready by now
+                if (i > 0) save(i - 1);
+            }
+            if (opt.frames > 0) save(opt.frames - 1);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+            std::cout << "Headless: wrote " << opt.frames << " frames to " << opt.outDir << "\n";
+        }
+    }
+
+    glfwTerminate();
+    return rc;
+}
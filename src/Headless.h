@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+
+// Batch frame generation without a visible window: renders `frames` frames
+// along a scripted camera path into an FBO and writes them as PPM files.
+struct HeadlessOptions {
+    int frames = 60;
+    int width = 1280, height = 720;
+    std::string outDir = "frames";
+    std::string cameraPath;   // CameraPath file; empty = CameraPath::defaultTour()
+    std::string scenePath;
+};
+
+// returns the process exit code
+int runHeadless(const HeadlessOptions& opt);
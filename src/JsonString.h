@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+
+// a string for the inside of a JSON "..." literal; for names that come
+// from files (scene item labels, paths) or the driver
+inline std::string jsonEscape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') { out += '\\'; out += c; }
+        else if ((unsigned char)c < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", (unsigned)(unsigned char)c);
+            out += buf;
+        }
+        else out += c;
+    }
+    return out;
+}
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "CpuProfiler.h"
+#include "Frustum.h"
+#include "GLState.h"
+#include "RenderStats.h"
+#include "SceneFile.h"   // LightDesc
+#include "WorkerPool.h"
+
+// Clustered forward lighting. The view frustum is cut into kTilesX x kTilesY
+// screen tiles times kSlices depth slices (exponential in view depth), and
+// every cluster gets the list of point lights whose sphere of influence
+// touches its view-space bounds. Depth slices are assigned in parallel on a
+// WorkerPool; the result goes to three texture buffers that lighting.glsl
+// reads, so a fragment only loops over the lights of its own cluster:
+//   clusterGrid   RG32UI   per cluster: first index, light count
+//   clusterLights R16UI    light indices, grouped by cluster
+//   lightData     RGBA32F  per light: position + radius, color
+class LightClusters {
+public:
+    // keep in sync with lighting.glsl
+    static const int kTilesX = 16, kTilesY = 9, kSlices = 24;
+    static const int kClusters = kTilesX * kTilesY * kSlices;
+    static const int kMaxPerCluster = 256;   // further lights in one cluster are dropped
+    static constexpr size_t kMaxLights = 65536;  // 16-bit indices
+    static const GLuint kTextureUnit = 4;    // grid, indices, lights on units 4..6
+
+    // threads: workers besides the caller, -1 = one per hardware thread
+    explicit LightClusters(int threads = -1) : pool(threads) {}
+
+    ~LightClusters() {
+        if (!buffers[0]) return;  // never uploaded (CPU-only use)
+        glState().deleteTextures(3, textures);
+        glState().deleteBuffers(3, buffers);
+    }
+
+    LightClusters(const LightClusters&) = delete;
+    LightClusters& operator=(const LightClusters&) = delete;
+
+    // CPU only: bin world-space lights for this view; zNear / zFar are proj's
+    void assign(const std::vector<LightDesc>& lights, const glm::mat4& view, const glm::mat4& proj,
+        float zNear, float zFar) {
+        PROFILE_SCOPE("lightClusters");
+        if (proj != boundsProj || zNear != nearZ || zFar != farZ) buildBounds(proj, zNear, zFar);
+
+        const size_t n = std::min(lights.size(), kMaxLights);
+        const Frustum viewFrustum = Frustum::fromMatrix(proj);  // planes in view space
+        spheres.resize(n);
+        lightTexels.resize(2 * n);
+        for (size_t i = 0; i < n; ++i) {
+            const LightDesc& l = lights[i];
+            Sphere& s = spheres[i];
+            s.center = glm::vec3(view * glm::vec4(l.pos, 1.0f));
+            s.radius = l.radius;
+            float depth = -s.center.z;
+            if (viewFrustum.test(Aabb{ s.center, glm::vec3(s.radius) }) == CullResult::Outside) { s.slice0 = 1; s.slice1 = 0; }
+            else { s.slice0 = sliceOf(depth - s.radius); s.slice1 = sliceOf(depth + s.radius); }
+            lightTexels[2 * i] = glm::vec4(l.pos, l.radius);
+            lightTexels[2 * i + 1] = glm::vec4(l.color, 0.0f);
+        }
+
+        // each slice owns its clusters, so workers never share a list
+        counts.assign(kClusters, 0);
+        slots.resize((size_t)kClusters * kMaxPerCluster);
+        pool.forEach(kSlices, [this](int slice) { assignSlice(slice); });
+
+        grid.resize(2 * kClusters);
+        indices.clear();
+        occupied = 0;
+        for (int c = 0; c < kClusters; ++c) {
+            grid[2 * c] = (uint32_t)indices.size();
+            grid[2 * c + 1] = counts[c];
+            occupied += counts[c] > 0;
+            const uint16_t* list = &slots[(size_t)c * kMaxPerCluster];
+            indices.insert(indices.end(), list, list + counts[c]);
+        }
+    }
+
+    // GL: send the last assign() to the texture buffers (light data only when it changed)
+    void upload() {
+        if (!buffers[0]) create();
+        auto send = [&](int i, const void* data, size_t bytes) {
+            static const uint32_t zero = 0;
+            glState().bindBuffer(GL_TEXTURE_BUFFER, buffers[i]);
+            // orphan; a TBO never gets an empty store
+            if (bytes) glBufferData(GL_TEXTURE_BUFFER, bytes, data, GL_STREAM_DRAW);
+            else glBufferData(GL_TEXTURE_BUFFER, sizeof(zero), &zero, GL_STREAM_DRAW);
+            ++renderStats().bufferUploads;
+        };
+        send(0, grid.data(), grid.size() * sizeof(uint32_t));
+        send(1, indices.data(), indices.size() * sizeof(uint16_t));
+        if (lightTexels != uploadedTexels) {
+            send(2, lightTexels.data(), lightTexels.size() * sizeof(glm::vec4));
+            uploadedTexels = lightTexels;
+        }
+        glState().bindBuffer(GL_TEXTURE_BUFFER, 0);
+        renderStats().lightIndices += indices.size();
+    }
+
+    void bind() const {
+        for (int i = 0; i < 3; ++i) glState().bindTexture(kTextureUnit + i, GL_TEXTURE_BUFFER, textures[i]);
+    }
+
+    // clusterScale in frame_uniforms.glsl: xy = tiles per pixel,
+    // slice = log(depth) * z + w
+    glm::vec4 shaderScale(int width, int height) const {
+        return glm::vec4((float)kTilesX / width, (float)kTilesY / height, sliceScale, sliceBias);
+    }
+
+    size_t indexCount() const { return indices.size(); }
+    size_t occupiedClusters() const { return occupied; }  // with at least one light
+    unsigned threadCount() const { return pool.threadCount(); }
+
+private:
+    struct Sphere {
+        glm::vec3 center;  // view space
+        float radius;
+        int slice0, slice1;  // depth slices it reaches (slice0 > slice1: none)
+    };
+
+    struct Bounds {
+        glm::vec3 lo, hi;  // view space
+    };
+
+    WorkerPool pool;
+
+    // view-space cluster bounds, rebuilt when the projection changes
+    glm::mat4 boundsProj = glm::mat4(0.0f);
+    float nearZ = 0.0f, farZ = 0.0f;
+    float sliceScale = 0.0f, sliceBias = 0.0f;
+    std::vector<Bounds> bounds;
+
+    std::vector<Sphere> spheres;
+    std::vector<uint16_t> counts;  // per cluster
+    std::vector<uint16_t> slots;   // kMaxPerCluster per cluster
+    std::vector<uint32_t> grid;
+    std::vector<uint16_t> indices;
+    size_t occupied = 0;
+    std::vector<glm::vec4> lightTexels, uploadedTexels;
+
+    GLuint buffers[3] = {}, textures[3] = {};
+
+    float sliceDepth(int slice) const {
+        return nearZ * std::pow(farZ / nearZ, (float)slice / kSlices);
+    }
+
+    int sliceOf(float depth) const {
+        if (depth <= nearZ) return 0;
+        return std::min(kSlices - 1, (int)(std::log(depth) * sliceScale + sliceBias));
+    }
+
+    void buildBounds(const glm::mat4& proj, float zNear, float zFar) {
+        boundsProj = proj;
+        nearZ = zNear;
+        farZ = zFar;
+        sliceScale = kSlices / std::log(zFar / zNear);
+        sliceBias = -kSlices * std::log(zNear) / std::log(zFar / zNear);
+
+        // view-space direction through an NDC point, scaled to depth 1
+        const glm::mat4 inv = glm::inverse(proj);
+        auto ray = [&](float x, float y) {
+            glm::vec4 p = inv * glm::vec4(x, y, -1.0f, 1.0f);
+            glm::vec3 v = glm::vec3(p) / p.w;
+            return v / -v.z;
+        };
+
+        bounds.resize(kClusters);
+        for (int s = 0; s < kSlices; ++s) {
+            float d0 = sliceDepth(s), d1 = sliceDepth(s + 1);
+            for (int y = 0; y < kTilesY; ++y) {
+                for (int x = 0; x < kTilesX; ++x) {
+                    float nx0 = 2.0f * x / kTilesX - 1.0f, nx1 = 2.0f * (x + 1) / kTilesX - 1.0f;
+                    float ny0 = 2.0f * y / kTilesY - 1.0f, ny1 = 2.0f * (y + 1) / kTilesY - 1.0f;
+                    const glm::vec3 rays[4] = { ray(nx0, ny0), ray(nx1, ny0), ray(nx0, ny1), ray(nx1, ny1) };
+                    Bounds& b = bounds[(s * kTilesY + y) * kTilesX + x];
+                    b.lo = b.hi = rays[0] * d0;
+                    for (const glm::vec3& r : rays) {
+                        b.lo = glm::min(b.lo, glm::min(r * d0, r * d1));
+                        b.hi = glm::max(b.hi, glm::max(r * d0, r * d1));
+                    }
+                }
+            }
+        }
+    }
+
+    void assignSlice(int slice) {
+        const float d0 = sliceDepth(slice), d1 = sliceDepth(slice + 1);
+        for (size_t i = 0; i < spheres.size(); ++i) {
+            const Sphere& l = spheres[i];
+            if (slice < l.slice0 || slice > l.slice1) continue;
+
+            // screen rect of the light's bounding box, cut to this slice
+            // (perspective: ndc = P00 * x / depth - P20, same for y)
+            const float r = l.radius, depth = -l.center.z;
+            const float inv0 = 1.0f / std::max(d0, depth - r), inv1 = 1.0f / std::min(d1, depth + r);
+            const float px = boundsProj[0][0], py = boundsProj[1][1];
+            const float ox = boundsProj[2][0], oy = boundsProj[2][1];
+            const float ax = px * (l.center.x - r), bx = px * (l.center.x + r);
+            const float ay = py * (l.center.y - r), by = py * (l.center.y + r);
+            const float x0 = std::min(ax * inv0, ax * inv1) - ox, x1 = std::max(bx * inv0, bx * inv1) - ox;
+            const float y0 = std::min(ay * inv0, ay * inv1) - oy, y1 = std::max(by * inv0, by * inv1) - oy;
+            int tx0 = std::max(0, (int)std::floor((x0 * 0.5f + 0.5f) * kTilesX));
+            int tx1 = std::min(kTilesX - 1, (int)std::floor((x1 * 0.5f + 0.5f) * kTilesX));
+            int ty0 = std::max(0, (int)std::floor((y0 * 0.5f + 0.5f) * kTilesY));
+            int ty1 = std::min(kTilesY - 1, (int)std::floor((y1 * 0.5f + 0.5f) * kTilesY));
+
+            for (int y = ty0; y <= ty1; ++y) {
+                for (int x = tx0; x <= tx1; ++x) {
+                    int c = (slice * kTilesY + y) * kTilesX + x;
+                    // sphere vs the cluster's box: distance to the closest point
+                    const Bounds& b = bounds[c];
+                    float dx = std::max(0.0f, std::max(b.lo.x - l.center.x, l.center.x - b.hi.x));
+                    float dy = std::max(0.0f, std::max(b.lo.y - l.center.y, l.center.y - b.hi.y));
+                    float dz = std::max(0.0f, std::max(b.lo.z - l.center.z, l.center.z - b.hi.z));
+                    if (dx * dx + dy * dy + dz * dz > r * r) continue;
+                    uint16_t& count = counts[c];
+                    if (count < kMaxPerCluster) slots[(size_t)c * kMaxPerCluster + count++] = (uint16_t)i;
+                }
+            }
+        }
+    }
+
+    void create() {
+        glGenBuffers(3, buffers);
+        glGenTextures(3, textures);
+        const GLenum formats[3] = { GL_RG32UI, GL_R16UI, GL_RGBA32F };
+        for (int i = 0; i < 3; ++i) {
+            glState().bindBuffer(GL_TEXTURE_BUFFER, buffers[i]);
+            glBufferData(GL_TEXTURE_BUFFER, sizeof(uint32_t), nullptr, GL_STREAM_DRAW);
+            glState().bindTexture(kTextureUnit + i, GL_TEXTURE_BUFFER, textures[i]);
+            glTexBuffer(GL_TEXTURE_BUFFER, formats[i], buffers[i]);
+        }
+        glState().bindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+};
@@ -0,0 +1,58 @@
+#include "MappedFile.h"
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool MappedFile::open(const std::string& path, std::string& err) {
+    close();
+
+#ifdef _WIN32
+    HANDLE fh = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fh == INVALID_HANDLE_VALUE) { err = "cannot open " + path; return false; }
+    LARGE_INTEGER sz;
+    GetFileSizeEx(fh, &sz);
+    HANDLE mh = CreateFileMappingA(fh, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mh) { CloseHandle(fh); err = "cannot map " + path; return false; }
+    base = (const unsigned char*)MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0);
+    if (!base) { CloseHandle(mh); CloseHandle(fh); err = "cannot map " + path; return false; }
+    file = fh;
+    mapping = mh;
+    length = (size_t)sz.QuadPart;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) { err = "cannot open " + path + ": " + std::strerror(errno); return false; }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) { ::close(fd); err = "cannot stat " + path; return false; }
+    void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) { err = "cannot map " + path + ": " + std::strerror(errno); return false; }
+    base = (const unsigned char*)p;
+    length = (size_t)st.st_size;
+#endif
+    return true;
+}
+
+void MappedFile::close() {
+    if (!base) return;
+#ifdef _WIN32
+    UnmapViewOfFile(base);
+    CloseHandle((HANDLE)mapping);
+    CloseHandle((HANDLE)file);
+    mapping = file = nullptr;
+#else
+    munmap((void*)base, length);
+#endif
+    base = nullptr;
+    length = 0;
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "GLState.h"
+
+// Vertex as the GPU sees it: half-float position (w unused) and a signed
+// normalized 10:10:10:2 normal, 12 bytes instead of 6 floats (24)
+struct PackedVertex {
+    uint16_t pos[4];
+    uint32_t normal;
+};
+
+static_assert(sizeof(PackedVertex) == 12, "PackedVertex must stay tightly packed");
+
+// float -> IEEE half, round to nearest; tiny values flush to zero and huge
+// ones become infinity, neither happens for mesh-space positions
+inline uint16_t toHalf(float f) {
+    uint32_t x;
+    std::memcpy(&x, &f, sizeof(x));
+    uint32_t sign = (x >> 16) & 0x8000;
+    int exp = (int)((x >> 23) & 0xFF) - 127 + 15;
+    uint32_t mant = x & 0x7FFFFF;
+    if (exp <= 0) return (uint16_t)sign;
+    if (exp >= 31) return (uint16_t)(sign | 0x7C00);
+    uint32_t h = sign | (uint32_t)exp << 10 | mant >> 13;
+    if (mant & 0x1000) ++h;  // a carry into the exponent is still the right value
+    return (uint16_t)h;
+}
+
+// unit vector -> GL_INT_2_10_10_10_REV (x in the low bits, w = 0)
+inline uint32_t packNormal(float x, float y, float z) {
+    auto snorm10 = [](float v) {
+        return (uint32_t)(int)std::lround(std::min(1.0f, std::max(-1.0f, v)) * 511.0f) & 0x3FF;
+    };
+    return snorm10(x) | snorm10(y) << 10 | snorm10(z) << 20;
+}
+
+// from x y z nx ny nz
+inline PackedVertex packVertex(const float* v) {
+    return PackedVertex{ { toHalf(v[0]), toHalf(v[1]), toHalf(v[2]), 0 }, packNormal(v[3], v[4], v[5]) };
+}
+
+// position (0) and normal (1) of the bound VAO from PackedVertex data in
+// the bound array buffer
+inline void setPackedVertexPointers() {
+    glVertexAttribPointer(0, 3, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, pos));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, normal));
+    glEnableVertexAttribArray(1);
+}
+
+// Where one mesh lives inside a MeshPool's shared buffers
+struct Mesh {
+    GLuint firstIndex = 0;   // into the index buffer
+    GLuint indexCount = 0;
+    GLint baseVertex = 0;    // added to every index
+};
+
+// GL's DrawElementsIndirectCommand, field for field: what one
+// glMultiDrawElementsIndirect entry (or one fallback draw) needs
+struct DrawCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;   // first instance of the command in the instance streams
+
+    static DrawCommand of(const Mesh& m, GLuint instances, GLuint first) {
+        return DrawCommand{ m.indexCount, instances, m.firstIndex, m.baseVertex, first };
+    }
+};
+
+// Every static mesh in one vertex buffer (PackedVertex) and one 32-bit
+// index buffer, so any mix of meshes is drawn from the same VAO and can go
+// out in a single multi-draw. Meshes are appended on the CPU as x y z
+// nx ny nz floats and packed on the way in; upload() (re)creates the GL
+// buffers.
+class MeshPool {
+public:
+    static const int kVertexFloats = 6;  // per source vertex: x y z, nx ny nz
+
+    MeshPool() = default;
+    ~MeshPool() {
+        if (vbo) glState().deleteBuffers(1, &vbo);
+        if (ibo) glState().deleteBuffers(1, &ibo);
+    }
+    MeshPool(const MeshPool&) = delete;
+    MeshPool& operator=(const MeshPool&) = delete;
+
+    Mesh add(const float* vertexData, size_t vertexCount, const uint32_t* indexData, size_t indexCount) {
+        Mesh m;
+        m.firstIndex = (GLuint)indices.size();
+        m.indexCount = (GLuint)indexCount;
+        m.baseVertex = (GLint)vertices.size();
+        for (size_t i = 0; i < vertexCount; ++i) vertices.push_back(packVertex(vertexData + i * kVertexFloats));
+        indices.insert(indices.end(), indexData, indexData + indexCount);
+        dirty = true;
+        return m;
+    }
+
+    void upload() {
+        if (!dirty) return;
+        if (!vbo) glGenBuffers(1, &vbo);
+        if (!ibo) glGenBuffers(1, &ibo);
+        glState().bindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(PackedVertex), vertices.data(), GL_STATIC_DRAW);
+        // the element binding belongs to a VAO; buffers are untyped, so fill
+        // the indices through the array target instead
+        glState().bindBuffer(GL_ARRAY_BUFFER, ibo);
+        glBufferData(GL_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+        renderStats().bufferUploads += 2;
+        dirty = false;
+    }
+
+    // point a VAO's position (0) and normal (1) at the shared vertices and
+    // give it the shared indices; call after upload()
+    void setupVAO(GLuint vao) const {
+        glState().bindVertexArray(vao);
+        glState().bindBuffer(GL_ARRAY_BUFFER, vbo);
+        setPackedVertexPointers();
+        glState().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+        glState().bindVertexArray(0);
+    }
+
+    size_t vertexCount() const { return vertices.size(); }
+    size_t indexCount() const { return indices.size(); }
+
+private:
+    std::vector<PackedVertex> vertices;
+    std::vector<uint32_t> indices;
+    GLuint vbo = 0, ibo = 0;
+    bool dirty = false;
+};
@@ -0,0 +1,203 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Frustum.h"
+
+// Hierarchical-Z occlusion test on the CPU. Large boxes (walls, table tops,
+// the TV stand body, ...) are rasterized into a small depth buffer, which is
+// reduced into a max-depth pyramid; a group's AABB is hidden when its
+// nearest depth lies behind the farthest occluder depth over its screen
+// footprint, read from the pyramid level where that footprint is ~2x2
+// texels. Software rasterization keeps the test free of GPU round trips
+// (no query latency, no readback) at the cost of a coarse buffer.
+//
+// The buffer stays conservative: an occluder face writes only the texels
+// it covers completely, each with the farthest depth the face has inside
+// it, so a texel never claims more occlusion than the real image has.
+class OcclusionCuller {
+public:
+    static const int kWidth = 128, kHeight = 64;
+
+    // boxes this big (second-largest side, world units) are used as occluders
+    static bool isOccluder(const glm::mat4& M) {
+        float s[3] = { glm::length(glm::vec3(M[0])), glm::length(glm::vec3(M[1])), glm::length(glm::vec3(M[2])) };
+        std::sort(s, s + 3);
+        return s[1] >= 0.4f;
+    }
+
+    void begin(const glm::mat4& viewProj) {
+        vp = viewProj;
+        levels.resize(1);
+        levels[0].w = kWidth;
+        levels[0].h = kHeight;
+        levels[0].depth.assign(kWidth * kHeight, 1.0f);
+    }
+
+    // the unit cube under M, depth-only
+    void rasterizeBox(const glm::mat4& M) {
+        // corners counter-clockwise seen from outside
+        static const int faces[6][4] = {
+            { 0, 1, 3, 2 }, { 4, 6, 7, 5 },  // -x, +x
+            { 0, 4, 5, 1 }, { 2, 3, 7, 6 },  // -y, +y
+            { 0, 2, 6, 4 }, { 1, 5, 7, 3 },  // -z, +z
+        };
+        glm::mat4 m = vp * M;
+        glm::vec4 clip[8];
+        for (int i = 0; i < 8; ++i)
+            clip[i] = m * glm::vec4((i & 4) ? 0.5f : -0.5f, (i & 2) ? 0.5f : -0.5f, (i & 1) ? 0.5f : -0.5f, 1.0f);
+        for (const int* f : faces) clipAndDraw(clip[f[0]], clip[f[1]], clip[f[2]], clip[f[3]]);
+    }
+
+    // build the max-depth pyramid; call after the last rasterizeBox
+    void finish() {
+        while (levels.back().w > 1 || levels.back().h > 1) {
+            const Level& src = levels.back();
+            Level dst;
+            dst.w = std::max(1, (src.w + 1) / 2);
+            dst.h = std::max(1, (src.h + 1) / 2);
+            dst.depth.resize(dst.w * dst.h);
+            for (int y = 0; y < dst.h; ++y)
+                for (int x = 0; x < dst.w; ++x) {
+                    float d = src.at(2 * x, 2 * y);
+                    d = std::max(d, src.at(std::min(2 * x + 1, src.w - 1), 2 * y));
+                    d = std::max(d, src.at(2 * x, std::min(2 * y + 1, src.h - 1)));
+                    d = std::max(d, src.at(std::min(2 * x + 1, src.w - 1), std::min(2 * y + 1, src.h - 1)));
+                    dst.depth[y * dst.w + x] = d;
+                }
+            levels.push_back(std::move(dst));
+        }
+    }
+
+    // false only if the box is certainly hidden behind the occluders
+    bool visible(const Aabb& b) const {
+        glm::vec3 lo = b.min(), hi = b.max();
+        float x0 = 1e30f, y0 = 1e30f, x1 = -1e30f, y1 = -1e30f, zMin = 1e30f;
+        for (int i = 0; i < 8; ++i) {
+            glm::vec4 c = vp * glm::vec4((i & 4) ? hi.x : lo.x, (i & 2) ? hi.y : lo.y, (i & 1) ? hi.z : lo.z, 1.0f);
+            if (c.w <= kNearW) return true;  // reaches behind the eye
+            glm::vec3 ndc = glm::vec3(c) / c.w;
+            x0 = std::min(x0, ndc.x); x1 = std::max(x1, ndc.x);
+            y0 = std::min(y0, ndc.y); y1 = std::max(y1, ndc.y);
+            zMin = std::min(zMin, ndc.z * 0.5f + 0.5f);
+        }
+
+        // footprint in level-0 texels, clamped to the screen
+        int px0 = std::max(0, (int)std::floor((x0 * 0.5f + 0.5f) * kWidth));
+        int py0 = std::max(0, (int)std::floor((y0 * 0.5f + 0.5f) * kHeight));
+        int px1 = std::min(kWidth - 1, (int)std::floor((x1 * 0.5f + 0.5f) * kWidth));
+        int py1 = std::min(kHeight - 1, (int)std::floor((y1 * 0.5f + 0.5f) * kHeight));
+        if (px0 > px1 || py0 > py1) return true;  // off screen: the frustum test's call
+
+        // coarsest level where the footprint spans at most 2 texels per axis
+        int level = 0;
+        while (level + 1 < (int)levels.size() && ((px1 >> level) - (px0 >> level) > 1 || (py1 >> level) - (py0 >> level) > 1))
+            ++level;
+        const Level& l = levels[level];
+        float maxDepth = 0.0f;
+        for (int y = py0 >> level; y <= (py1 >> level); ++y)
+            for (int x = px0 >> level; x <= (px1 >> level); ++x)
+                maxDepth = std::max(maxDepth, l.at(x, y));
+        return zMin <= maxDepth;
+    }
+
+private:
+    static constexpr float kNearW = 1e-3f;
+
+    struct Level {
+        int w = 0, h = 0;
+        std::vector<float> depth;  // window depth [0, 1], 1 = far / empty
+        float at(int x, int y) const { return depth[y * w + x]; }
+    };
+
+    glm::mat4 vp;
+    std::vector<Level> levels;
+
+    // clip against w = kNearW (the only plane that matters for projection),
+    // then draw the face as one convex polygon: whole faces, not triangle
+    // pairs, so texels along a quad's diagonal still count as covered
+    void clipAndDraw(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c, const glm::vec4& d) {
+        const glm::vec4 in[4] = { a, b, c, d };
+        glm::vec4 out[8];
+        int n = 0;
+        for (int i = 0; i < 4; ++i) {
+            const glm::vec4& p = in[i];
+            const glm::vec4& q = in[(i + 1) % 4];
+            bool pIn = p.w > kNearW, qIn = q.w > kNearW;
+            if (pIn) out[n++] = p;
+            if (pIn != qIn) {
+                float t = (kNearW - p.w) / (q.w - p.w);
+                out[n++] = p + (q - p) * t;
+            }
+        }
+        if (n >= 3) drawPolygon(out, n);
+    }
+
+    void drawPolygon(const glm::vec4* clip, int n) {
+        // to pixel space; z to window depth, which is affine in screen space
+        // (the face is planar)
+        glm::vec3 v[8];
+        for (int i = 0; i < n; ++i)
+            v[i] = glm::vec3((clip[i].x / clip[i].w * 0.5f + 0.5f) * kWidth, (clip[i].y / clip[i].w * 0.5f + 0.5f) * kHeight,
+                clip[i].z / clip[i].w * 0.5f + 0.5f);
+
+        // counter-clockwise = front facing; a closed box loses nothing by
+        // skipping its back faces. The depth plane comes from the largest
+        // fan triangle, the best conditioned one
+        float area = 0.0f, best = 0.0f;
+        int bi = 1;
+        for (int i = 1; i + 1 < n; ++i) {
+            float t = (v[i].x - v[0].x) * (v[i + 1].y - v[0].y) - (v[i].y - v[0].y) * (v[i + 1].x - v[0].x);
+            area += t;
+            if (t > best) { best = t; bi = i; }
+        }
+        if (area <= 1e-8f || best <= 1e-8f) return;
+
+        const glm::vec3 p0 = v[0], p1 = v[bi], p2 = v[bi + 1];
+        const float dzdx = ((p1.z - p0.z) * (p2.y - p0.y) - (p2.z - p0.z) * (p1.y - p0.y)) / best;
+        const float dzdy = ((p2.z - p0.z) * (p1.x - p0.x) - (p1.z - p0.z) * (p2.x - p0.x)) / best;
+        // from a texel center to its farthest corner, in depth
+        const float zSpread = 0.5f * (std::fabs(dzdx) + std::fabs(dzdy));
+
+        float minX = v[0].x, maxX = v[0].x, minY = v[0].y, maxY = v[0].y;
+        for (int i = 1; i < n; ++i) {
+            minX = std::min(minX, v[i].x); maxX = std::max(maxX, v[i].x);
+            minY = std::min(minY, v[i].y); maxY = std::max(maxY, v[i].y);
+        }
+        int x0 = std::max(0, (int)std::floor(minX));
+        int x1 = std::min(kWidth - 1, (int)std::ceil(maxX) - 1);
+        int y0 = std::max(0, (int)std::floor(minY));
+        int y1 = std::min(kHeight - 1, (int)std::ceil(maxY) - 1);
+        if (x0 > x1 || y0 > y1) return;
+
+        // edge functions E_i = A_i x + B_i y + C_i, positive inside; a whole
+        // texel is inside edge i when E_i at its center is at least half
+        // the texel's extent along the edge normal
+        float A[8], B[8], C[8];
+        for (int i = 0; i < n; ++i) {
+            const glm::vec3& p = v[i];
+            const glm::vec3& q = v[(i + 1) % n];
+            A[i] = p.y - q.y;
+            B[i] = q.x - p.x;
+            C[i] = -(A[i] * p.x + B[i] * p.y) - 0.5f * (std::fabs(A[i]) + std::fabs(B[i]));
+        }
+
+        Level& l = levels[0];
+        for (int y = y0; y <= y1; ++y) {
+            const float py = y + 0.5f;
+            float* row = &l.depth[y * kWidth];
+            for (int x = x0; x <= x1; ++x) {
+                const float px = x + 0.5f;
+                bool covered = true;
+                for (int i = 0; i < n && covered; ++i) covered = A[i] * px + B[i] * py + C[i] >= 0.0f;
+                if (!covered) continue;
+                const float z = p0.z + dzdx * (px - p0.x) + dzdy * (py - p0.y) + zSpread;
+                if (z >= 0.0f && z < row[x]) row[x] = z;
+            }
+        }
+    }
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "GLState.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// FBO (RGBA8 color + depth renderbuffers) for rendering without a visible
+// window, plus two pixel-pack buffers so frame N's readback overlaps frame
+// N+1's rendering instead of stalling in glReadPixels.
+class OffscreenTarget {
+public:
+    int width = 0, height = 0;
+
+    OffscreenTarget(int w, int h) : width(w), height(h) {
+        glGenFramebuffers(1, &fbo);
+        glGenRenderbuffers(1, &colorRB);
+        glGenRenderbuffers(1, &depthRB);
+
+        glBindRenderbuffer(GL_RENDERBUFFER, colorRB);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, w, h);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthRB);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, w, h);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorRB);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthRB);
+        complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        glGenBuffers(2, pbo);
+        for (unsigned int b : pbo) {
+            glState().bindBuffer(GL_PIXEL_PACK_BUFFER, b);
+            glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)w * h * 4, nullptr, GL_STREAM_READ);
+        }
+        glState().bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    ~OffscreenTarget() {
+        glState().deleteBuffers(2, pbo);
+        glDeleteRenderbuffers(1, &colorRB);
+        glDeleteRenderbuffers(1, &depthRB);
+        glDeleteFramebuffers(1, &fbo);
+    }
+
+    OffscreenTarget(const OffscreenTarget&) = delete;
+    OffscreenTarget& operator=(const OffscreenTarget&) = delete;
+
+    bool ok() const { return complete; }
+
+    void bind() const { glBindFramebuffer(GL_FRAMEBUFFER, fbo); }
+
+    // start an async readback of the current frame into PBO (frame & 1)
+    void beginRead(int frame) {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+        glState().bindBuffer(GL_PIXEL_PACK_BUFFER, pbo[frame & 1]);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glState().bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    // finish the readback started by beginRead(frame); rows bottom-up, RGBA
+    bool endRead(int frame, std::vector<unsigned char>& rgba) {
+        rgba.resize((size_t)width * height * 4);
+        glState().bindBuffer(GL_PIXEL_PACK_BUFFER, pbo[frame & 1]);
+        const void* p = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)rgba.size(), GL_MAP_READ_BIT);
+        bool ok = p != nullptr;
+        if (ok) {
+            std::copy((const unsigned char*)p, (const unsigned char*)p + rgba.size(), rgba.begin());
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glState().bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        return ok;
+    }
+
+private:
+    unsigned int fbo = 0, colorRB = 0, depthRB = 0;
+    unsigned int pbo[2] = {};
+    bool complete = false;
+};
+
+// binary PPM (P6); flips the bottom-up GL rows
+inline bool writePPM(const std::string& path, const std::vector<unsigned char>& rgba, int w, int h) {
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+    std::fprintf(f, "P6\n%d %d\n255\n", w, h);
+    std::vector<unsigned char> row((size_t)w * 3);
+    for (int y = h - 1; y >= 0; --y) {
+        const unsigned char* src = &rgba[(size_t)y * w * 4];
+        for (int x = 0; x < w; ++x) {
+            row[x * 3 + 0] = src[x * 4 + 0];
+            row[x * 3 + 1] = src[x * 4 + 1];
+            row[x * 3 + 2] = src[x * 4 + 2];
+        }
+        std::fwrite(row.data(), 1, row.size(), f);
+    }
+    return std::fclose(f) == 0;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+
+// Repo root, set by CMake so shaders/scenes load no matter where the exe
+// is launched from. Falls back to the working directory.
+#ifndef FINALROOM_SOURCE_DIR
+#define FINALROOM_SOURCE_DIR "."
+#endif
+
+// "src/room.vert" -> "<repo>/src/room.vert"
+inline std::string assetPath(const std::string& rel) {
+    return std::string(FINALROOM_SOURCE_DIR) + "/" + rel;
+}
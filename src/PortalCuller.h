@@ -0,0 +1,195 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "BoxBvh.h"
+#include "Frustum.h"
+#include "SceneFile.h"
+
+// Cell-and-portal visibility. Every room is a cell holding each box that
+// overlaps its volume (a box straddling a doorway, or the wall two rooms
+// share, is in both); doorways (SceneDesc::portals) connect cells.
+// Starting from the camera's cell, a portal leads on only if its screen
+// rectangle overlaps the rectangle we are looking through, and the neighbour
+// is then seen through the intersection. Each reached cell is frustum culled
+// (its own BVH) against the union of the rectangles it was seen through.
+// Boxes outside every room, or a camera outside every room, fall back to
+// plain frustum culling.
+class PortalCuller {
+public:
+    static const int kMaxDepth = 16;  // portals followed from the camera's cell
+
+    bool empty() const { return cells.empty(); }
+    int cellsVisible() const { return visibleCount; }
+
+    // cells from desc's rooms, filled with every instance [0, count) by its
+    // bounds, so nothing depends on the order items were added in
+    void build(const SceneDesc& desc, const glm::mat4* models, size_t count) {
+        cells.assign(desc.rooms.size(), Cell{});
+        portals.clear();
+        const float t = 0.1f;  // slab thickness in emitRoom
+
+        for (size_t r = 0; r < cells.size(); ++r) {
+            const RoomDesc& room = desc.rooms[r];
+            cells[r].lo = room.center - glm::vec3(room.size.x * 0.5f, t, room.size.z * 0.5f);
+            cells[r].hi = room.center + glm::vec3(room.size.x * 0.5f, room.size.y + t, room.size.z * 0.5f);
+        }
+
+        std::vector<std::vector<uint32_t>> ids(cells.size());
+        std::vector<uint32_t> outsideIds;
+        shared = false;
+        for (size_t i = 0; i < count; ++i) {
+            const Aabb box = boxAabb(models[i]);
+            const glm::vec3 lo = box.min(), hi = box.max();
+            int in = 0;
+            for (size_t r = 0; r < cells.size(); ++r) {
+                const Cell& c = cells[r];
+                // strictly: a floor slab ending where the next room starts is not in it
+                if (lo.x < c.hi.x && hi.x > c.lo.x && lo.y < c.hi.y && hi.y > c.lo.y && lo.z < c.hi.z && hi.z > c.lo.z) {
+                    ids[r].push_back((uint32_t)i);
+                    ++in;
+                }
+            }
+            if (in == 0) outsideIds.push_back((uint32_t)i);
+            shared = shared || in > 1;
+        }
+        seenFrame.assign(count, 0);
+        frame = 0;
+
+        for (size_t r = 0; r < cells.size(); ++r) cells[r].bvh.build(models, ids[r]);
+        outside.build(models, outsideIds);
+
+        for (const PortalDesc& p : desc.portals) {
+            Portal portal;
+            portal.a = (int)p.roomA;
+            portal.b = (int)p.roomB;
+            // flat along x or z: the four corners of the opening
+            bool alongX = p.max.x - p.min.x > p.max.z - p.min.z;
+            glm::vec3 lo = p.min, hi = p.max;
+            portal.corners[0] = lo;
+            portal.corners[1] = alongX ? glm::vec3(hi.x, lo.y, lo.z) : glm::vec3(lo.x, lo.y, hi.z);
+            portal.corners[2] = hi;
+            portal.corners[3] = alongX ? glm::vec3(lo.x, hi.y, hi.z) : glm::vec3(hi.x, hi.y, lo.z);
+            cells[portal.a].portals.push_back((int)portals.size());
+            cells[portal.b].portals.push_back((int)portals.size());
+            portals.push_back(portal);
+        }
+    }
+
+    // append visible instance indices, each once
+    void cull(const glm::vec3& eye, const glm::mat4& viewProj, std::vector<uint32_t>& visible) {
+        for (Cell& c : cells) c.seen = false;
+        visibleCount = 0;
+
+        const Rect full{ -1.0f, -1.0f, 1.0f, 1.0f };
+        int start = cellAt(eye);
+        if (start >= 0) {
+            visit(start, full, viewProj, -1, 0);
+        }
+        else {
+            for (Cell& c : cells) { c.seen = true; c.rect = full; }
+        }
+
+        const size_t first = visible.size();
+        for (Cell& c : cells) {
+            if (!c.seen) continue;
+            ++visibleCount;
+            c.bvh.cull(Frustum::fromMatrix(viewProj, c.rect.x0, c.rect.y0, c.rect.x1, c.rect.y1), visible);
+        }
+        outside.cull(Frustum::fromMatrix(viewProj), visible);
+
+        // boxes in several cells may have been reported by each of them
+        if (!shared) return;
+        if (++frame == 0) {
+            std::fill(seenFrame.begin(), seenFrame.end(), 0u);
+            frame = 1;
+        }
+        size_t out = first;
+        for (size_t i = first; i < visible.size(); ++i) {
+            uint32_t& mark = seenFrame[visible[i]];
+            if (mark == frame) continue;
+            mark = frame;
+            visible[out++] = visible[i];
+        }
+        visible.resize(out);
+    }
+
+private:
+    struct Rect {
+        float x0, y0, x1, y1;  // NDC
+        bool empty() const { return x0 >= x1 || y0 >= y1; }
+        bool contains(const Rect& r) const { return r.x0 >= x0 && r.y0 >= y0 && r.x1 <= x1 && r.y1 <= y1; }
+    };
+
+    struct Cell {
+        glm::vec3 lo, hi;            // room volume, slabs included
+        BoxBvh bvh;
+        std::vector<int> portals;
+        Rect rect{ 0, 0, 0, 0 };     // union of what the cell is seen through
+        bool seen = false;
+    };
+
+    struct Portal {
+        int a, b;
+        glm::vec3 corners[4];
+    };
+
+    std::vector<Cell> cells;
+    std::vector<Portal> portals;
+    BoxBvh outside;
+    int visibleCount = 0;
+
+    bool shared = false;               // some box is in more than one cell
+    std::vector<uint32_t> seenFrame;   // per instance: last cull() that reported it
+    uint32_t frame = 0;
+
+    int cellAt(const glm::vec3& p) const {
+        for (size_t i = 0; i < cells.size(); ++i) {
+            const Cell& c = cells[i];
+            if (p.x >= c.lo.x && p.y >= c.lo.y && p.z >= c.lo.z && p.x <= c.hi.x && p.y <= c.hi.y && p.z <= c.hi.z)
+                return (int)i;
+        }
+        return -1;
+    }
+
+    // screen bounds of a portal clipped to `clip`; false if it can't be seen
+    static bool project(const Portal& p, const glm::mat4& viewProj, const Rect& clip, Rect& out) {
+        Rect r{ 1.0f, 1.0f, -1.0f, -1.0f };
+        int behind = 0;
+        for (const glm::vec3& c : p.corners) {
+            glm::vec4 h = viewProj * glm::vec4(c, 1.0f);
+            if (h.w <= 1e-5f) { ++behind; continue; }
+            r.x0 = std::min(r.x0, h.x / h.w); r.x1 = std::max(r.x1, h.x / h.w);
+            r.y0 = std::min(r.y0, h.y / h.w); r.y1 = std::max(r.y1, h.y / h.w);
+        }
+        if (behind == 4) return false;
+        // crosses the eye plane (standing in the doorway): no narrowing
+        if (behind > 0) r = clip;
+        out = Rect{ std::max(r.x0, clip.x0), std::max(r.y0, clip.y0),
+                    std::min(r.x1, clip.x1), std::min(r.y1, clip.y1) };
+        return !out.empty();
+    }
+
+    void visit(int cell, const Rect& rect, const glm::mat4& viewProj, int from, int depth) {
+        Cell& c = cells[cell];
+        if (!c.seen) { c.rect = rect; c.seen = true; }
+        else c.rect = Rect{ std::min(c.rect.x0, rect.x0), std::min(c.rect.y0, rect.y0),
+                            std::max(c.rect.x1, rect.x1), std::max(c.rect.y1, rect.y1) };
+        if (depth >= kMaxDepth) return;
+
+        for (int pi : c.portals) {
+            if (pi == from) continue;
+            const Portal& p = portals[pi];
+            int next = p.a == cell ? p.b : p.a;
+            Rect r;
+            if (!project(p, viewProj, rect, r)) continue;
+            // already seen through a larger window: nothing new behind it
+            if (cells[next].seen && cells[next].rect.contains(r)) continue;
+            visit(next, r, viewProj, pi, depth + 1);
+        }
+    }
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <vector>
+
+#include "GLState.h"
+
+// Draws recorded during a pass and submitted sorted by a 64-bit key, so
+// draws that share a program / VAO run back to back and GLState drops the
+// rebinds inside each run:
+//   bits 63..52  program  (low 12 bits of the GL name)
+//        51..40  VAO
+//        39..8   distance from the eye, front to back
+// Textures are not part of it: the scene's materials are one array bound
+// once per frame (TextureArray), so no draw binds its own.
+// The key only orders; every draw keeps its full state, so two names that
+// share their low bits just sort next to each other and are still bound
+// correctly. A draw is a plain function pointer with a context pointer and
+// an argument (no std::function, so submitting allocates nothing once the
+// vectors have grown).
+//
+//   queue.submit(shader.ID, vao, dist, &drawItem, this, i);
+//   queue.flush();
+class RenderQueue {
+public:
+    static uint64_t makeKey(GLuint program, GLuint vao, float depth) {
+        // a non-negative float's bits sort like the float
+        uint32_t bits = 0;
+        if (depth > 0.0f) std::memcpy(&bits, &depth, sizeof(bits));
+        return (uint64_t)(program & 0xFFF) << 52 | (uint64_t)(vao & 0xFFF) << 40
+            | (uint64_t)bits << 8;
+    }
+
+    // draw(ctx, arg) issues the draw call(s) with program and VAO bound
+    using DrawFn = void (*)(void* ctx, size_t arg);
+
+    void submit(GLuint program, GLuint vao, float depth, DrawFn draw, void* ctx, size_t arg) {
+        order.push_back({ makeKey(program, vao, depth), (uint32_t)draws.size() });
+        draws.push_back({ program, vao, draw, ctx, arg });
+    }
+
+    size_t size() const { return draws.size(); }
+
+    // sort, bind (through GLState), draw; empties the queue
+    void flush() {
+        std::sort(order.begin(), order.end(), [](const Entry& a, const Entry& b) {
+            return a.key != b.key ? a.key < b.key : a.index < b.index;  // equal keys keep submit order
+        });
+
+        GLState& gl = glState();
+        for (const Entry& e : order) {
+            Draw& d = draws[e.index];
+            gl.useProgram(d.program);
+            gl.bindVertexArray(d.vao);
+            d.draw(d.ctx, d.arg);
+        }
+        order.clear();
+        draws.clear();
+    }
+
+private:
+    struct Entry {
+        uint64_t key;
+        uint32_t index;  // into draws
+    };
+
+    struct Draw {
+        GLuint program, vao;
+        DrawFn draw;
+        void* ctx;
+        size_t arg;
+    };
+
+    std::vector<Entry> order;  // what gets sorted; the draws themselves stay put
+    std::vector<Draw> draws;
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+// Per-frame counters bumped by the draw/upload paths (BoxBatch, Shader,
+// FrameUniforms, TextureLoader) and read by the benchmarks. Reset at the
+// start of a frame.
+struct RenderStats {
+    uint64_t drawCalls = 0;
+    uint64_t instances = 0;       // boxes submitted
+    uint64_t culled = 0;          // boxes rejected before submission
+    uint64_t cells = 0;           // rooms reached through portals
+    uint64_t occludedGroups = 0;  // furniture pieces hidden by occlusion culling
+    uint64_t lightIndices = 0;    // entries in the clustered light lists
+    uint64_t uniformUploads = 0;  // glUniform* calls
+    uint64_t bufferUploads = 0;   // UBO / instance buffer writes
+    uint64_t textureBytes = 0;    // texels streamed into textures (TextureLoader)
+    uint64_t stateCalls = 0;      // binds / state changes GLState passed on to GL
+    uint64_t stateSkipped = 0;    // ... and the ones it dropped as redundant
+    uint64_t shadedFragments = 0; // GL_SAMPLES_PASSED in the lit forward pass (a few frames late)
+
+    void reset() { *this = RenderStats{}; }
+};
+
+inline RenderStats& renderStats() {
+    static RenderStats stats;
+    return stats;
+}
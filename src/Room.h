@@ -2,7 +2,8 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include "Cube.h"
-#include "Shader.h"
+#include "shader.h"
+#include "Transform.h"
 
 class Room {
 public:
@@ -16,6 +17,7 @@ public:
         model = glm::translate(model, glm::vec3(0, -0.5f, 0));
         model = glm::scale(model, glm::vec3(10, 0.1f, 14));
         shader.setMat4("model", model);
+        shader.setMat3("normalMatrix", normalMatrix(model));
         cube.Draw();
 
         // Back wall
@@ -23,6 +25,7 @@ public:
         model = glm::translate(model, glm::vec3(0, 2, -7));
         model = glm::scale(model, glm::vec3(10, 4, 0.1f));
         shader.setMat4("model", model);
+        shader.setMat3("normalMatrix", normalMatrix(model));
         cube.Draw();
 
         // Front wall
@@ -30,6 +33,7 @@ public:
         model = glm::translate(model, glm::vec3(0, 2, 7));
         model = glm::scale(model, glm::vec3(10, 4, 0.1f));
         shader.setMat4("model", model);
+        shader.setMat3("normalMatrix", normalMatrix(model));
         cube.Draw();
 
         // Left wall
@@ -37,6 +41,7 @@ public:
         model = glm::translate(model, glm::vec3(-5, 2, 0));
         model = glm::scale(model, glm::vec3(0.1f, 4, 14));
         shader.setMat4("model", model);
+        shader.setMat3("normalMatrix", normalMatrix(model));
         cube.Draw();
 
         // Right wall
@@ -44,6 +49,7 @@ public:
         model = glm::translate(model, glm::vec3(5, 2, 0));
         model = glm::scale(model, glm::vec3(0.1f, 4, 14));
         shader.setMat4("model", model);
+        shader.setMat3("normalMatrix", normalMatrix(model));
         cube.Draw();
 
         // Ceiling
@@ -51,6 +57,7 @@ public:
         model = glm::translate(model, glm::vec3(0, 4, 0));
         model = glm::scale(model, glm::vec3(10, 0.1f, 14));
         shader.setMat4("model", model);
+        shader.setMat3("normalMatrix", normalMatrix(model));
         cube.Draw();
     }
 };
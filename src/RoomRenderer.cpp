@@ -0,0 +1,454 @@
+#include "RoomRenderer.h"
+
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "CpuProfiler.h"
+#include "Cube.h"
+#include "Frustum.h"
+#include "GLExt.h"
+#include "GLState.h"
+#include "Paths.h"
+
+static bool endsWith(const std::string& s, const std::string& suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// VAO over the pool's shared vertices / indices; instance streams are attached by a BoxBatch
+static unsigned int makeMeshVAO(const MeshPool& pool) {
+    unsigned int vao = 0;
+    glGenVertexArrays(1, &vao);
+    pool.setupVAO(vao);
+    return vao;
+}
+
+// "room.frag" -> "<repo>/src/room.frag"
+static std::string shaderPath(const char* name) {
+    return assetPath(std::string("src/") + name);
+}
+
+RoomRenderer::RoomRenderer()
+    // programs compile / link side by side (driver threads where it has
+    // them) and are finished below, once the meshes are set up
+    : solidShader(shaderPath("room.vert").c_str(), shaderPath("room.frag").c_str(), false),
+      gbufferShader(shaderPath("room.vert").c_str(), shaderPath("gbuffer.frag").c_str(), false),
+      lightingShader(shaderPath("deferred.vert").c_str(), shaderPath("deferred.frag").c_str(), false),
+      depthShader(shaderPath("depth.vert").c_str(), shaderPath("depth.frag").c_str(), false)
+{
+    programs.push_back({ &solidShader, "room.vert", "room.frag", nullptr });
+    programs.push_back({ &gbufferShader, "room.vert", "gbuffer.frag", nullptr });
+    programs.push_back({ &lightingShader, "deferred.vert", "deferred.frag", nullptr });
+    programs.push_back({ &depthShader, "depth.vert", "depth.frag", nullptr });
+
+    // --- meshes (just the cube so far) and their VAOs ---
+    cubeMesh = Cube::addTo(meshes);
+    meshes.upload();
+    cubeVAO = makeMeshVAO(meshes);
+    cullVAO = makeMeshVAO(meshes);
+
+    // static scene: every box baked once into per-instance arrays on the same VAO
+    scene.boxes.attach(cubeVAO, cubeMesh);
+    visible.attach(cullVAO, cubeMesh);
+
+    for (Program& p : programs) p.shader->finish();
+    setSamplers();
+
+    // the full-screen triangle has no attributes, but core profile wants a VAO
+    glGenVertexArrays(1, &emptyVAO);
+
+    glGenQueries(kFragmentQueries, fragmentQueries);
+}
+
+RoomRenderer::~RoomRenderer() {
+    for (Program& p : programs) {
+        if (p.next) p.next->cancel();
+        if (p.shader->ID) glState().deleteProgram(p.shader->ID);
+    }
+    const GLuint vaos[3] = { cubeVAO, cullVAO, emptyVAO };
+    glState().deleteVertexArrays(3, vaos);
+    glDeleteQueries(kFragmentQueries, fragmentQueries);
+}
+
+void RoomRenderer::setSamplers() {
+    // cluster light lists are texture buffers on fixed units, and so is
+    // the G-buffer for the deferred lighting pass
+    for (Shader* s : { &solidShader, &lightingShader }) {
+        s->use();
+        s->setInt("clusterGrid", LightClusters::kTextureUnit);
+        s->setInt("clusterLights", LightClusters::kTextureUnit + 1);
+        s->setInt("lightData", LightClusters::kTextureUnit + 2);
+    }
+    // furniture materials (texture array), sampled by both scene programs
+    for (Shader* s : { &solidShader, &gbufferShader }) {
+        s->use();
+        s->setInt("materials", TextureArray::kTextureUnit);
+    }
+    lightingShader.use();
+    lightingShader.setInt("gAlbedo", 0);
+    lightingShader.setInt("gNormal", 1);
+    lightingShader.setInt("gDepth", 2);
+}
+
+void RoomRenderer::updateShaders(const std::vector<std::string>& files) {
+    auto includes = [](const Shader* s, const std::string& f) {
+        return s && std::find(s->includes.begin(), s->includes.end(), f) != s->includes.end();
+    };
+    for (Program& p : programs) {
+        bool uses = false;
+        for (const std::string& f : files)
+            uses = uses || f == p.vert || f == p.frag || includes(p.shader, f) || includes(p.next.get(), f);
+        if (uses) {
+            // an edit while the last one is still building: that one is stale
+            if (p.next) p.next->cancel();
+            p.next = std::make_unique<Shader>(shaderPath(p.vert).c_str(), shaderPath(p.frag).c_str(), false,
+                shaderCompiler);
+        }
+        if (!p.next || !p.next->ready()) continue;
+
+        if (p.next->finish()) {
+            std::swap(*p.shader, *p.next);
+            setSamplers();   // sampler units are program state
+            std::cerr << "reloaded " << p.vert << " + " << p.frag << "\n";
+        }
+        else {
+            std::cerr << "reload of " << p.vert << " + " << p.frag << " failed, keeping the old program\n";
+        }
+        glState().deleteProgram(p.next->ID);
+        p.next.reset();
+    }
+}
+
+bool RoomRenderer::loadScene(const std::string& path, std::string& err) {
+    // generators run once, re-run only when marked dirty;
+    // .rscn is memory-mapped and its instance streams go straight to the GPU
+    const size_t firstItem = scene.itemCount();
+    if (endsWith(path, ".rscn")) {
+        if (!mapped.open(path, err)) return false;
+        mapped.toDesc(sceneDesc);
+        populateScene(scene, mapped);
+    }
+    else {
+        if (!loadSceneText(path, sceneDesc, err)) return false;
+        mapped.close();
+        populateScene(scene, sceneDesc);
+    }
+    applyMaterials(firstItem);
+    scene.bake();
+    bvhDirty = true;
+
+    // scene lights replace the defaults one by one
+    for (size_t i = 0; i < sceneDesc.lights.size(); ++i) {
+        if (i < lights.size()) lights[i] = sceneDesc.lights[i];
+        else lights.push_back(sceneDesc.lights[i]);
+    }
+    return true;
+}
+
+void RoomRenderer::applyMaterials(size_t firstItem) {
+    // populateScene adds the rooms, then the furniture in file order
+    const size_t furnitureItem = firstItem + sceneDesc.rooms.size();
+    for (size_t i = 0; i < sceneDesc.furniture.size(); ++i) {
+        for (const FurnitureMaterial& m : furnitureMaterials) {
+            if (m.type != sceneDesc.furniture[i].type) continue;
+            BoxMaterial material;
+            material.uvTransform = glm::vec4(m.repeats, m.repeats, 0.0f, 0.0f);
+            material.layer = (float)materials.add(assetPath(m.texture));
+            scene.setMaterial(furnitureItem + i, material);
+            break;
+        }
+    }
+    // reallocate only when the set of images grew
+    if ((int)materials.layers() != materialLayers) {
+        PROFILE_SCOPE("materials.build");
+        materials.build(textures);
+        materialLayers = (int)materials.layers();
+    }
+}
+
+void RoomRenderer::renderFrame(const ViewState& v, int width, int height) {
+    PROFILE_SCOPE("renderFrame");
+    textures.update();
+    glViewport(0, 0, width, height);
+    glClearColor(0.08f, 0.08f, 0.1f, 1.0f);
+    {
+        GpuProfiler::Scope pass(profiler, "clear");
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
+
+    glm::mat4 viewProj;
+    {
+        PROFILE_SCOPE("frameUniforms");
+        // camera matrices
+        glm::mat4 view = glm::lookAt(v.camPos, v.camPos + v.camFront, v.camUp);
+        const float zNear = 0.1f, zFar = 100.0f;
+        glm::mat4 proj = glm::perspective(glm::radians(45.0f), (float)width / (float)height, zNear, zFar);
+        viewProj = proj * view;
+
+        FrameUniformsData frame{};
+        frame.view = view;
+        frame.projection = proj;
+        frame.viewPos = v.camPos;
+
+        // point lights: every one goes through the clusters, the first two
+        // are also in the block for the ambient term
+        if (lights.size() > 0) { frame.lightPos0 = lights[0].pos; frame.lightColor0 = lights[0].color; }
+        if (lights.size() > 1) { frame.lightPos1 = lights[1].pos; frame.lightColor1 = lights[1].color; }
+        lightClusters.assign(lights, view, proj, zNear, zFar);
+        lightClusters.upload();
+        frame.clusterScale = lightClusters.shaderScale(width, height);
+
+        // flashlight (camera-mounted)
+        frame.useFlashlight = v.flashlightOn ? 1 : 0;
+        frame.flashDir = glm::normalize(v.camFront);
+        // inner/outer cone angles
+        float innerDeg = 15.0f;
+        float outerDeg = 22.0f;
+        frame.flashCutoff = std::cos(glm::radians(innerDeg));
+        frame.flashOuterCutoff = std::cos(glm::radians(outerDeg));
+        frame.flashColor = glm::vec3(1.0f, 0.98f, 0.9f);
+
+        // ambient scaling (night mode)
+        frame.ambientScale = v.nightMode ? 0.05f : 0.15f;
+
+        // fog
+        frame.useFog = v.fogOn ? 1 : 0;
+        frame.fogColor = glm::vec3(0.12f, 0.12f, 0.14f);
+        frame.fogDensity = 0.03f;
+
+        frameUniforms.update(frame);
+    }
+
+    // re-bake anything marked dirty (nothing, for a static room), then
+    // one instanced draw for the whole scene
+    {
+        PROFILE_SCOPE("scene.bake");
+        if (scene.bake() > 0) bvhDirty = true;
+    }
+    // culled, or just put in front-to-back order for the pre-pass
+    if (drawsVisible() && !(profiler && profiler->splitPasses)) cullScene(v.camPos, viewProj);
+    materials.bind();
+
+    if (deferred) {
+        // the scene goes into the G-buffer and is lit afterwards
+        GLint target = 0;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target);
+        gbuffer.resize(width, height);
+        gbuffer.bind();
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        {
+            PROFILE_SCOPE("scene.draw");
+            drawScene("scene", gbufferShader, v.camPos);
+        }
+
+        PROFILE_SCOPE("lighting");
+        GpuProfiler::Scope pass(profiler, "lighting");
+        glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)target);
+        lightingShader.use();
+        lightingShader.setMat4("invViewProj", glm::inverse(viewProj));
+        gbuffer.bindTextures(0);
+        lightClusters.bind();
+        glState().enable(GL_DEPTH_TEST, false);
+        glState().bindVertexArray(emptyVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        ++renderStats().drawCalls;
+        glState().enable(GL_DEPTH_TEST, true);
+        return;
+    }
+
+    if (depthPrepass) {
+        // depth only, then the lit pass shades just the fragments that
+        // match it: one lighting evaluation per visible pixel
+        PROFILE_SCOPE("prepass");
+        glState().colorMask(false);
+        drawScene("prepass", depthShader, v.camPos);
+        glState().colorMask(true);
+        glState().depthFunc(GL_EQUAL);
+        glState().depthMask(false);
+    }
+
+    lightClusters.bind();
+    {
+        PROFILE_SCOPE("scene.draw");
+        beginFragmentCount();
+        drawScene("scene", solidShader, v.camPos);
+        glEndQuery(GL_SAMPLES_PASSED);
+    }
+
+    if (depthPrepass) {
+        glState().depthFunc(GL_LESS);
+        glState().depthMask(true);
+    }
+}
+
+void RoomRenderer::drawScene(const char* pass, const Shader& shader, const glm::vec3& eye) {
+    if (profiler && profiler->splitPasses) {
+        // one draw per item so every room / furniture piece gets its own time
+        // (unculled, so the numbers stay comparable frame to frame); nearest
+        // item first, by its nearest box, so the pre-pass still fills depth
+        // front to back. The queue sorts them
+        const glm::mat4* models = instanceModels();
+        for (size_t i = 0; i < scene.itemCount(); ++i) {
+            if (scene.itemBoxes(i) == 0) continue;
+            float dist = 1e30f;
+            for (size_t b = scene.itemFirst(i); b < scene.itemFirst(i) + scene.itemBoxes(i); ++b)
+                dist = std::min(dist, glm::length(glm::vec3(models[b][3]) - eye));
+            queue.submit(shader.ID, cubeVAO, dist, &RoomRenderer::drawQueuedItem, this, i);
+        }
+        queue.flush();
+        return;
+    }
+
+    // otherwise the whole pass is one draw: nothing to sort
+    shader.use();
+    GpuProfiler::Scope p(profiler, pass);
+    if (frustumCulling && drawRuns) {
+        glState().bindVertexArray(cubeVAO);
+        scene.boxes.drawCommands(visibleRuns);
+    }
+    else if (drawsVisible()) {
+        glState().bindVertexArray(cullVAO);
+        visible.draw();
+    }
+    else {
+        glState().bindVertexArray(cubeVAO);
+        scene.draw();
+    }
+}
+
+void RoomRenderer::drawQueuedItem(void* self, size_t item) {
+    RoomRenderer* r = (RoomRenderer*)self;
+    GpuProfiler::Scope p(r->profiler, r->scene.itemLabel(item));
+    r->scene.drawItem(item);
+}
+
+const glm::mat4* RoomRenderer::instanceModels() const {
+    // wherever the baked models live (see cullScene)
+    return scene.boxes.isExternal() ? mapped.models() : scene.boxes.models.data();
+}
+
+void RoomRenderer::beginFragmentCount() {
+    // the slot's query was issued kFragmentQueries frames ago; report it if
+    // the GPU is done with it, never wait
+    fragmentSlot = (fragmentSlot + 1) % kFragmentQueries;
+    GLuint q = fragmentQueries[fragmentSlot];
+    if (fragmentPending[fragmentSlot]) {
+        GLuint ready = 0;
+        glGetQueryObjectuiv(q, GL_QUERY_RESULT_AVAILABLE, &ready);
+        if (ready) {
+            GLuint64 samples = 0;
+            glGetQueryObjectui64v(q, GL_QUERY_RESULT, &samples);
+            renderStats().shadedFragments = samples;
+        }
+    }
+    glBeginQuery(GL_SAMPLES_PASSED, q);
+    fragmentPending[fragmentSlot] = true;
+}
+
+void RoomRenderer::cullScene(const glm::vec3& eye, const glm::mat4& viewProj) {
+    // baked instances live in the vectors, or only in the mapped file
+    // (and GL) right after loading a .rscn
+    const BoxBatch& all = scene.boxes;
+    bool external = all.isExternal();
+    const glm::mat4* models = instanceModels();
+    const glm::mat3* normals = external ? mapped.normals() : all.normals.data();
+    const glm::vec3* colors = external ? mapped.colors() : all.colors.data();
+
+    PROFILE_SCOPE("cull");
+    visibleIds.clear();
+    if (frustumCulling) {
+        if (bvhDirty) {
+            bvh.build(models, all.size());
+            cells.build(sceneDesc, models, all.size());
+            buildOcclusionData(models);
+            bvhDirty = false;
+        }
+        if (portalCulling && !cells.empty()) {
+            cells.cull(eye, viewProj, visibleIds);
+            renderStats().cells += cells.cellsVisible();
+        }
+        else {
+            bvh.cull(Frustum::fromMatrix(viewProj), visibleIds);
+        }
+        if (occlusionCulling) cullOccluded(viewProj, models);
+        renderStats().culled += all.size() - visibleIds.size();
+    }
+    else {
+        // only here for the pre-pass: every box, sorted below
+        visibleIds.resize(all.size());
+        for (size_t i = 0; i < visibleIds.size(); ++i) visibleIds[i] = (uint32_t)i;
+    }
+
+    drawRuns = frustumCulling && indirectDraws && GLExt::multiDrawIndirect && !depthPrepass;
+    if (drawRuns) {
+        // draw the visible instances where they are: one command per run of
+        // consecutive ids, all in one multi-draw, nothing copied or uploaded
+        std::sort(visibleIds.begin(), visibleIds.end());
+        visibleRuns.clear();
+        for (uint32_t id : visibleIds) {
+            if (!visibleRuns.empty()) {
+                DrawCommand& run = visibleRuns.back();
+                if (run.baseInstance + run.instanceCount == id) { ++run.instanceCount; continue; }
+            }
+            visibleRuns.push_back(DrawCommand::of(cubeMesh, 1, id));
+        }
+        return;
+    }
+
+    if (depthPrepass) {
+        // front to back (box centers), so the pre-pass rejects as much as it can early
+        auto dist2 = [&](uint32_t id) {
+            glm::vec3 d = glm::vec3(models[id][3]) - eye;
+            return glm::dot(d, d);
+        };
+        std::sort(visibleIds.begin(), visibleIds.end(), [&](uint32_t a, uint32_t b) { return dist2(a) < dist2(b); });
+    }
+
+    visible.clear();
+    for (uint32_t id : visibleIds) visible.add(models[id], normals[id], colors[id], all.material(id));
+}
+
+void RoomRenderer::buildOcclusionData(const glm::mat4* models) {
+    itemOf.assign(scene.boxes.size(), 0);
+    occluder.assign(scene.boxes.size(), 0);
+    itemBounds.assign(scene.itemCount(), Aabb{});
+    for (size_t item = 0; item < scene.itemCount(); ++item) {
+        size_t first = scene.itemFirst(item), count = scene.itemBoxes(item);
+        for (size_t i = first; i < first + count; ++i) {
+            itemOf[i] = (uint32_t)item;
+            occluder[i] = OcclusionCuller::isOccluder(models[i]) ? 1 : 0;
+            itemBounds[item] = i == first ? boxAabb(models[i]) : merge(itemBounds[item], boxAabb(models[i]));
+        }
+    }
+}
+
+void RoomRenderer::cullOccluded(const glm::mat4& viewProj, const glm::mat4* models) {
+    PROFILE_SCOPE("occlusion");
+    occlusion.begin(viewProj);
+    for (uint32_t id : visibleIds)
+        if (occluder[id]) occlusion.rasterizeBox(models[id]);
+    occlusion.finish();
+
+    // walls and other big boxes occlude; room shells are always drawn and
+    // furniture pieces are tested as a whole (one verdict per piece, like
+    // the old one-draw-call-per-piece code)
+    const size_t rooms = sceneDesc.rooms.size();
+    itemVerdict.assign(scene.itemCount(), 0);
+    size_t kept = 0;
+    for (uint32_t id : visibleIds) {
+        uint32_t item = itemOf[id];
+        if (item >= rooms) {
+            uint8_t& v = itemVerdict[item];
+            if (v == 0) {
+                v = occlusion.visible(itemBounds[item]) ? 1 : 2;
+                if (v == 2) ++renderStats().occludedGroups;
+            }
+            if (v == 2) continue;
+        }
+        visibleIds[kept++] = id;
+    }
+    visibleIds.resize(kept);
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "shader.h"
+#include "BakedScene.h"
+#include "BoxBvh.h"
+#include "SceneFile.h"
+#include "FrameUniforms.h"
+#include "GBuffer.h"
+#include "GpuProfiler.h"
+#include "LightClusters.h"
+#include "MeshPool.h"
+#include "OcclusionCuller.h"
+#include "PortalCuller.h"
+#include "RenderQueue.h"
+#include "TextureArray.h"
+#include "TextureLoader.h"
+
+// everything a frame depends on besides the scene itself
+struct ViewState {
+    glm::vec3 camPos = glm::vec3(1.5f, 1.4f, 6.0f);
+    glm::vec3 camFront = glm::vec3(0.0f, 0.0f, -1.0f);
+    glm::vec3 camUp = glm::vec3(0.0f, 1.0f, 0.0f);
+    bool flashlightOn = true;
+    bool fogOn = false;
+    bool nightMode = false;   // dims ambient
+};
+
+// Owns the GL side of the living room (solid shader, cube VAO, baked scene,
+// per-frame UBO) so the interactive window, headless capture and the
+// benchmarks all draw through the same code. Needs a current GL context.
+class RoomRenderer {
+public:
+    RoomRenderer();
+    ~RoomRenderer();
+    RoomRenderer(const RoomRenderer&) = delete;
+    RoomRenderer& operator=(const RoomRenderer&) = delete;
+
+    // .scene (text) or .rscn (memory-mapped binary)
+    bool loadScene(const std::string& path, std::string& err);
+
+    // clear + draw into the currently bound framebuffer
+    void renderFrame(const ViewState& v, int width, int height);
+
+    // call once the frame is submitted (before swap / readback)
+    void endFrame() { frameUniforms.endFrame(); }
+
+    // shader hot reload, called at the frame boundary: rebuild every program
+    // that uses one of `files` (names in src/, e.g. "room.frag" or an
+    // #included "lighting.glsl", as ShaderWatcher reports them). A rebuilt
+    // program replaces the old one once it has linked: in a later call when
+    // the driver links in the background (KHR_parallel_shader_compile) or
+    // shaderCompiler is set, else in this one. One that fails is logged and
+    // dropped, and the old program stays.
+    void updateShaders(const std::vector<std::string>& files = {});
+
+    Shader solidShader;
+    MeshPool meshes;     // every static mesh in one vertex / index buffer
+    Mesh cubeMesh;
+    unsigned int cubeVAO = 0;
+    BakedScene scene;
+    SceneDesc sceneDesc;
+
+    // optional; when set, renderFrame times its passes (clear, scene or
+    // one pass per scene item when profiler->splitPasses)
+    GpuProfiler* profiler = nullptr;
+
+    // optional; when set, updateShaders builds on its thread on drivers
+    // without KHR_parallel_shader_compile. Must outlive the renderer
+    ShaderCompiler* shaderCompiler = nullptr;
+
+    // draw only boxes whose AABB touches the view frustum (BVH over the
+    // baked instances, rebuilt whenever a bake changes them)
+    bool frustumCulling = true;
+    // with frustumCulling: draw only rooms reachable through doorways in view
+    bool portalCulling = true;
+    // with frustumCulling: also drop furniture pieces hidden behind walls and
+    // other large boxes (CPU hierarchical-Z, see OcclusionCuller)
+    bool occlusionCulling = false;
+    // with frustumCulling: when the driver has glMultiDrawElementsIndirect,
+    // draw the visible instances in place (one command per run of
+    // consecutive instances, one call) instead of copying them into a
+    // compact batch. Not with depthPrepass, which needs them sorted
+    bool indirectDraws = true;
+
+    // deferred shading: the scene writes albedo / normal / depth into a
+    // G-buffer and one full-screen pass lights every pixel once (with the
+    // same light clusters), instead of lighting every fragment drawn
+    bool deferred = false;
+
+    // forward only: lay down depth first with a position-only shader (boxes
+    // sorted front to back), then light with GL_EQUAL so every visible
+    // pixel is shaded once; see RenderStats::shadedFragments
+    bool depthPrepass = false;
+
+    // textured furniture: every piece of `type` samples `texture` (relative
+    // to the repo), tiled `repeats` times a meter. loadScene packs the images
+    // into one texture array, so textured pieces still share the scene draw;
+    // they come in through `textures` over the next frames (finish() it for
+    // a first frame with everything in)
+    struct FurnitureMaterial {
+        FurnitureType type;
+        std::string texture;
+        float repeats;
+    };
+    std::vector<FurnitureMaterial> furnitureMaterials = {
+        { FurnitureType::Sofa, "textures/fabric.jpg", 2.0f },
+        { FurnitureType::Box, "textures/wall.jpg", 1.0f },
+    };
+    TextureLoader textures;   // update()d by renderFrame
+
+    // point lights, binned into clusters every frame; loadScene fills in the
+    // scene's (the first two also set the ambient, so there are always two)
+    std::vector<LightDesc> lights = {
+        { glm::vec3(0.0f, 3.0f, 2.5f), glm::vec3(1.0f), kLightRadius },                // ceiling-ish
+        { glm::vec3(0.0f, 1.0f, -2.2f), glm::vec3(1.0f, 0.95f, 0.80f), kLightRadius }, // near TV stand (warm)
+    };
+
+private:
+    FrameUniforms frameUniforms;
+
+    // every program and its files, for hot reload
+    struct Program {
+        Shader* shader;
+        const char* vert;
+        const char* frag;
+        std::unique_ptr<Shader> next;   // being rebuilt
+    };
+    std::vector<Program> programs;
+    LightClusters lightClusters;
+    TextureArray materials;
+    int materialLayers = -1;   // layers in the array as last built
+
+    void applyMaterials(size_t firstItem);
+    void setSamplers();
+
+    // deferred path
+    Shader gbufferShader, lightingShader;
+    GBuffer gbuffer;
+    unsigned int emptyVAO = 0;
+
+    // depth pre-pass, and GL_SAMPLES_PASSED of the lit pass (a small ring,
+    // read back once the GPU is done so the frame never waits on it)
+    Shader depthShader;
+    static const int kFragmentQueries = 4;
+    unsigned int fragmentQueries[kFragmentQueries] = {};
+    bool fragmentPending[kFragmentQueries] = {};
+    int fragmentSlot = 0;
+
+    // culling: the visible instances are copied into `visible`, which
+    // feeds a second VAO over the same meshes, or drawn in place as runs
+    MappedScene mapped;               // kept open: source of external instances
+    BoxBvh bvh;
+    PortalCuller cells;
+    bool bvhDirty = true;
+    std::vector<uint32_t> visibleIds;
+    BoxBatch visible;
+    unsigned int cullVAO = 0;
+    bool drawRuns = false;                  // this frame uses visibleRuns instead of visible
+    std::vector<DrawCommand> visibleRuns;   // into scene.boxes
+
+    // occlusion: per instance its scene item and whether it occludes; per
+    // item its bounds and this frame's verdict (0 untested, 1 shown, 2 hidden)
+    OcclusionCuller occlusion;
+    std::vector<uint32_t> itemOf;
+    std::vector<uint8_t> occluder;
+    std::vector<Aabb> itemBounds;
+    std::vector<uint8_t> itemVerdict;
+
+    // per-item draws (profiler->splitPasses) go through the queue (sorted
+    // by program, VAO, texture, distance; redundant binds skipped)
+    RenderQueue queue;
+
+    void drawScene(const char* pass, const Shader& shader, const glm::vec3& eye);
+    static void drawQueuedItem(void* self, size_t item);
+    const glm::mat4* instanceModels() const;
+    // frame draws from visibleIds (culled and / or sorted for the pre-pass)
+    bool drawsVisible() const { return frustumCulling || depthPrepass; }
+    void cullScene(const glm::vec3& eye, const glm::mat4& viewProj);
+    void beginFragmentCount();
+    void buildOcclusionData(const glm::mat4* models);
+    void cullOccluded(const glm::mat4& viewProj, const glm::mat4* models);
+};
@@ -0,0 +1,469 @@
+#include "SceneFile.h"
+
+#include "BakedScene.h"
+#include "CpuProfiler.h"
+#include "Furniture.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+// ---------------- text parser ----------------
+namespace {
+
+struct LineReader {
+    const char* p;
+    const char* end;
+
+    void skipSpaces() { while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p; }
+
+    bool atEnd() {
+        skipSpaces();
+        return p >= end || *p == '\n' || *p == '#';
+    }
+
+    bool word(const char*& s, size_t& n) {
+        skipSpaces();
+        s = p;
+        while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n' && *p != '#') ++p;
+        n = (size_t)(p - s);
+        return n > 0;
+    }
+
+    // strtof / strtoul want a NUL-terminated string and the buffer is not
+    // one (a number at its very end would be read past it), so each token
+    // is copied out first
+    bool token(char (&buf)[64]) {
+        const char* s; size_t n;
+        if (!word(s, n) || n >= sizeof(buf)) return false;
+        std::memcpy(buf, s, n);
+        buf[n] = '\0';
+        return true;
+    }
+
+    bool number(float& v) {
+        char buf[64];
+        if (!token(buf)) return false;
+        char* e = nullptr;
+        v = std::strtof(buf, &e);
+        return e != buf && *e == '\0';
+    }
+
+    bool vec3(glm::vec3& v) { return number(v.x) && number(v.y) && number(v.z); }
+
+    // 0xRRGGBB or RRGGBB
+    bool hex(glm::vec3& v) {
+        char buf[64];
+        if (!token(buf)) return false;
+        char* e = nullptr;
+        unsigned long h = std::strtoul(buf, &e, 16);
+        if (e == buf || *e != '\0') return false;
+        v = hexRGB((unsigned int)h);
+        return true;
+    }
+
+    void nextLine() {
+        while (p < end && *p != '\n') ++p;
+        if (p < end) ++p;
+    }
+};
+
+bool is(const char* s, size_t n, const char* kw) {
+    return std::strlen(kw) == n && std::memcmp(s, kw, n) == 0;
+}
+
+} // namespace
+
+bool parseSceneText(const char* text, size_t len, SceneDesc& out, std::string& err, const std::string& name) {
+    out = SceneDesc{};
+    LineReader r{ text, text + len };
+
+    for (int line = 1; r.p < r.end; ++line, r.nextLine()) {
+        if (r.atEnd()) continue;
+
+        const char* kw; size_t n;
+        r.word(kw, n);
+        bool ok = true;
+
+        if (is(kw, n, "room")) {
+            RoomDesc room{};
+            ok = r.vec3(room.center) && r.vec3(room.size) &&
+                 r.hex(room.floorCol) && r.hex(room.ceilCol) && r.hex(room.backCol) &&
+                 r.hex(room.frontCol) && r.hex(room.sideCol);
+            out.rooms.push_back(room);
+        }
+        else if (is(kw, n, "light")) {
+            LightDesc l{};
+            l.radius = kLightRadius;
+            ok = r.vec3(l.pos) && r.vec3(l.color);
+            if (ok && !r.atEnd()) ok = r.number(l.radius) && l.radius > 0.0f;
+            out.lights.push_back(l);
+        }
+        else if (is(kw, n, "portal")) {
+            PortalDesc p{};
+            float a = -1.0f, b = -1.0f;
+            glm::vec3 c0, c1;
+            ok = r.number(a) && r.number(b) && r.vec3(c0) && r.vec3(c1);
+            // both rooms must already be declared
+            ok = ok && a >= 0.0f && b >= 0.0f && a != b &&
+                 a < (float)out.rooms.size() && b < (float)out.rooms.size() &&
+                 a == (float)(uint32_t)a && b == (float)(uint32_t)b;
+            p.roomA = (uint32_t)a;
+            p.roomB = (uint32_t)b;
+            p.min = glm::min(c0, c1);
+            p.max = glm::max(c0, c1);
+            out.portals.push_back(p);
+        }
+        else {
+            FurnitureDesc f{};
+            f.scale = glm::vec3(1.0f);
+            if (is(kw, n, "coffee_table")) {
+                f.type = FurnitureType::CoffeeTable;
+                ok = r.vec3(f.pos) && r.number(f.yawDeg);
+                float s;
+                if (ok && !r.atEnd()) { ok = r.number(s); f.scale = glm::vec3(s); }
+            }
+            else if (is(kw, n, "tv_stand")) {
+                f.type = FurnitureType::TVStand;
+                ok = r.vec3(f.pos);
+            }
+            else if (is(kw, n, "sofa")) {
+                f.type = FurnitureType::Sofa;
+                ok = r.vec3(f.pos) && r.number(f.yawDeg);
+            }
+            else if (is(kw, n, "box")) {
+                f.type = FurnitureType::Box;
+                ok = r.vec3(f.pos) && r.vec3(f.scale) && r.hex(f.color);
+            }
+            else {
+                err = name + ":" + std::to_string(line) + ": unknown record '" + std::string(kw, n) + "'";
+                return false;
+            }
+            out.furniture.push_back(f);
+        }
+
+        if (!ok || !r.atEnd()) {
+            err = name + ":" + std::to_string(line) + ": bad arguments for '" + std::string(kw, n) + "'";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool loadSceneText(const std::string& path, SceneDesc& out, std::string& err) {
+    std::ifstream f(path, std::ios::binary);
+    if (!f) { err = "cannot open " + path; return false; }
+    std::stringstream ss;
+    ss << f.rdbuf();
+    std::string text = ss.str();
+    return parseSceneText(text.data(), text.size(), out, err, path);
+}
+
+// ---------------- generators ----------------
+const char* furnitureName(FurnitureType type) {
+    switch (type) {
+    case FurnitureType::Box: return "box";
+    case FurnitureType::CoffeeTable: return "coffee_table";
+    case FurnitureType::TVStand: return "tv_stand";
+    case FurnitureType::Sofa: return "sofa";
+    }
+    return "furniture";
+}
+
+std::vector<PortalDesc> roomPortals(const std::vector<PortalDesc>& portals, uint32_t index) {
+    std::vector<PortalDesc> out;
+    for (const PortalDesc& p : portals)
+        if (p.roomA == index || p.roomB == index) out.push_back(p);
+    return out;
+}
+
+namespace {
+
+// the four walls of a room, as in emitRoom: u = 0 runs along x, 2 along z
+struct RoomWall { int u; float plane, u0, u1; };
+
+void roomWalls(const RoomDesc& room, RoomWall (&out)[4]) {
+    const glm::vec3 c = room.center;
+    const float w = room.size.x, d = room.size.z;
+    out[0] = { 0, c.z - d * 0.5f, c.x - w * 0.5f, c.x + w * 0.5f };
+    out[1] = { 0, c.z + d * 0.5f, c.x - w * 0.5f, c.x + w * 0.5f };
+    out[2] = { 2, c.x - w * 0.5f, c.z - d * 0.5f, c.z + d * 0.5f };
+    out[3] = { 2, c.x + w * 0.5f, c.z - d * 0.5f, c.z + d * 0.5f };
+}
+
+} // namespace
+
+std::vector<WallSpan> sharedWalls(const std::vector<RoomDesc>& rooms, uint32_t index) {
+    std::vector<WallSpan> out;
+    const RoomDesc& room = rooms[index];
+    RoomWall mine[4], theirs[4];
+    roomWalls(room, mine);
+    for (uint32_t j = 0; j < index; ++j) {
+        const RoomDesc& other = rooms[j];
+        // only where the other wall is at least as tall as ours
+        if (other.center.y > room.center.y + 1e-4f ||
+            other.center.y + other.size.y < room.center.y + room.size.y - 1e-4f) continue;
+        roomWalls(other, theirs);
+        for (const RoomWall& a : mine)
+            for (const RoomWall& b : theirs) {
+                if (a.u != b.u || std::fabs(a.plane - b.plane) > 1e-3f) continue;
+                const float u0 = std::max(a.u0, b.u0), u1 = std::min(a.u1, b.u1);
+                if (u1 > u0) out.push_back(WallSpan{ a.u, a.plane, u0, u1 });
+            }
+    }
+    return out;
+}
+
+void emitRoom(const FurnitureContext& ctx, const RoomDesc& room, const std::vector<PortalDesc>& portals,
+    const std::vector<WallSpan>& skip) {
+    PROFILE_SCOPE("emitRoom");
+    auto block = [&](glm::vec3 pos, glm::vec3 scale, glm::vec3 col) {
+        glm::mat4 M(1.0f);
+        M = glm::translate(M, pos);
+        M = glm::scale(M, scale);
+        emitBox(ctx, M, col);
+    };
+
+    const glm::vec3 c = room.center;
+    const float w = room.size.x, h = room.size.y, d = room.size.z;
+    const float t = 0.1f; // wall/slab thickness
+
+    // A wall along axis u (0 = x, 2 = z) at `plane` on the other horizontal
+    // axis, spanning [u0, u1] x [c.y, c.y + h]. Portals in it become holes:
+    // full-height pieces between them, plus a lintel above (and a sill
+    // below) each opening. Without portals this is the single block.
+    auto span = [&](int u, float plane, float u0, float u1, glm::vec3 col) {
+        const int n = 2 - u;  // wall normal axis
+        auto piece = [&](float a0, float a1, float y0, float y1) {
+            if (a1 - a0 <= 1e-4f || y1 - y0 <= 1e-4f) return;
+            glm::vec3 pos, size;
+            pos[u] = (a0 + a1) * 0.5f; size[u] = a1 - a0;
+            pos[n] = plane;            size[n] = t;
+            pos.y = (y0 + y1) * 0.5f;  size.y = y1 - y0;
+            block(pos, size, col);
+        };
+
+        std::vector<const PortalDesc*> holes;
+        for (const PortalDesc& p : portals)
+            if (p.max[n] - p.min[n] < t && std::fabs(p.min[n] - plane) < t &&
+                p.max[u] > u0 && p.min[u] < u1)
+                holes.push_back(&p);
+        std::sort(holes.begin(), holes.end(),
+            [u](const PortalDesc* a, const PortalDesc* b) { return a->min[u] < b->min[u]; });
+
+        const float y0 = c.y, y1 = c.y + h;
+        float cursor = u0;
+        for (const PortalDesc* p : holes) {
+            float a0 = std::max(p->min[u], u0), a1 = std::min(p->max[u], u1);
+            piece(cursor, a0, y0, y1);
+            piece(std::max(a0, cursor), a1, std::max(p->max.y, y0), y1);
+            piece(std::max(a0, cursor), a1, y0, std::min(p->min.y, y1));
+            cursor = std::max(cursor, a1);
+        }
+        piece(cursor, u1, y0, y1);
+    };
+
+    // the parts of a wall no earlier room has built already (two rooms
+    // emitting the same wall would z-fight)
+    auto wall = [&](int u, float plane, float u0, float u1, glm::vec3 col) {
+        std::vector<const WallSpan*> done;
+        for (const WallSpan& s : skip)
+            if (s.axis == u && std::fabs(s.plane - plane) < t * 0.5f) done.push_back(&s);
+        std::sort(done.begin(), done.end(),
+            [](const WallSpan* a, const WallSpan* b) { return a->u0 < b->u0; });
+        float cursor = u0;
+        for (const WallSpan* s : done) {
+            if (s->u0 > cursor) span(u, plane, cursor, std::min(s->u0, u1), col);
+            cursor = std::max(cursor, s->u1);
+        }
+        if (cursor < u1) span(u, plane, cursor, u1, col);
+    };
+
+    block(c, { w, t, d }, room.floorCol);
+    block(c + glm::vec3(0.0f, h, 0.0f), { w, t, d }, room.ceilCol);
+    wall(0, c.z - d * 0.5f, c.x - w * 0.5f, c.x + w * 0.5f, room.backCol);
+    wall(0, c.z + d * 0.5f, c.x - w * 0.5f, c.x + w * 0.5f, room.frontCol);
+    wall(2, c.x - w * 0.5f, c.z - d * 0.5f, c.z + d * 0.5f, room.sideCol);
+    wall(2, c.x + w * 0.5f, c.z - d * 0.5f, c.z + d * 0.5f, room.sideCol);
+}
+
+void emitFurniture(const FurnitureContext& ctx, const FurnitureDesc& f) {
+    switch (f.type) {
+    case FurnitureType::CoffeeTable:
+        drawCoffeeTable(ctx, f.pos, f.yawDeg, f.scale);
+        break;
+    case FurnitureType::TVStand:
+        drawTVStand(ctx, f.pos);
+        break;
+    case FurnitureType::Sofa:
+        drawSofa(ctx, f.pos, f.yawDeg);
+        break;
+    case FurnitureType::Box: {
+        glm::mat4 M(1.0f);
+        M = glm::translate(M, f.pos);
+        M = glm::rotate(M, glm::radians(f.yawDeg), glm::vec3(0, 1, 0));
+        M = glm::scale(M, f.scale);
+        emitBox(ctx, M, f.color);
+        break;
+    }
+    }
+}
+
+void populateScene(BakedScene& scene, const SceneDesc& desc) {
+    for (uint32_t i = 0; i < desc.rooms.size(); ++i) {
+        RoomDesc room = desc.rooms[i];
+        std::vector<PortalDesc> doors = roomPortals(desc.portals, i);
+        std::vector<WallSpan> shared = sharedWalls(desc.rooms, i);
+        scene.add([room, doors, shared](const FurnitureContext& c) { emitRoom(c, room, doors, shared); }, "room");
+    }
+    for (const FurnitureDesc& f : desc.furniture)
+        scene.add([f](const FurnitureContext& c) { emitFurniture(c, f); }, furnitureName(f.type));
+}
+
+void populateScene(BakedScene& scene, const MappedScene& mapped) {
+    const SceneBinHeader& h = mapped.header();
+    scene.boxes.uploadExternal(mapped.models(), mapped.normals(), mapped.colors(), h.instanceCount);
+
+    std::vector<PortalDesc> portals(mapped.portals(), mapped.portals() + h.portalCount);
+    std::vector<RoomDesc> rooms(mapped.rooms(), mapped.rooms() + h.roomCount);
+    for (uint32_t i = 0; i < h.roomCount; ++i) {
+        const RoomDesc& room = rooms[i];
+        std::vector<PortalDesc> doors = roomPortals(portals, i);
+        std::vector<WallSpan> shared = sharedWalls(rooms, i);
+        scene.addBaked([room, doors, shared](const FurnitureContext& c) { emitRoom(c, room, doors, shared); },
+            room.first, room.count, "room");
+    }
+    for (uint32_t i = 0; i < h.furnitureCount; ++i) {
+        const FurnitureDesc& f = mapped.furniture()[i];
+        scene.addBaked([f](const FurnitureContext& c) { emitFurniture(c, f); }, f.first, f.count, furnitureName(f.type));
+    }
+}
+
+// ---------------- binary writer ----------------
+namespace {
+
+uint64_t align16(uint64_t v) { return (v + 15) & ~uint64_t(15); }
+
+template <class T>
+void writeAt(std::ofstream& f, uint64_t offset, const T* data, size_t count) {
+    f.seekp((std::streamoff)offset);
+    f.write((const char*)data, (std::streamsize)(count * sizeof(T)));
+}
+
+} // namespace
+
+bool saveSceneBinary(const std::string& path, const SceneDesc& desc) {
+    // bake on the CPU (BoxBatch without attach() never touches GL)
+    SceneDesc baked = desc;
+    BoxBatch boxes;
+    FurnitureContext ctx{ &boxes };
+    for (uint32_t i = 0; i < baked.rooms.size(); ++i) {
+        RoomDesc& room = baked.rooms[i];
+        room.first = (uint32_t)boxes.size();
+        emitRoom(ctx, room, roomPortals(baked.portals, i), sharedWalls(baked.rooms, i));
+        room.count = (uint32_t)boxes.size() - room.first;
+    }
+    for (FurnitureDesc& fd : baked.furniture) {
+        fd.first = (uint32_t)boxes.size();
+        emitFurniture(ctx, fd);
+        fd.count = (uint32_t)boxes.size() - fd.first;
+    }
+
+    SceneBinHeader h{};
+    std::memcpy(h.magic, "RSCN", 4);
+    h.version = kSceneBinVersion;
+    h.roomCount = (uint32_t)baked.rooms.size();
+    h.furnitureCount = (uint32_t)baked.furniture.size();
+    h.lightCount = (uint32_t)baked.lights.size();
+    h.instanceCount = (uint32_t)boxes.size();
+    h.portalCount = (uint32_t)baked.portals.size();
+
+    uint64_t off = align16(sizeof(SceneBinHeader));
+    h.roomsOffset = off;     off = align16(off + h.roomCount * sizeof(RoomDesc));
+    h.furnitureOffset = off; off = align16(off + h.furnitureCount * sizeof(FurnitureDesc));
+    h.lightsOffset = off;    off = align16(off + h.lightCount * sizeof(LightDesc));
+    h.portalsOffset = off;   off = align16(off + h.portalCount * sizeof(PortalDesc));
+    h.modelsOffset = off;    off = align16(off + h.instanceCount * sizeof(glm::mat4));
+    h.normalsOffset = off;   off = align16(off + h.instanceCount * sizeof(glm::mat3));
+    h.colorsOffset = off;    off = off + h.instanceCount * sizeof(glm::vec3);
+
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    if (!f) return false;
+    // pre-size so the padding between sections is zeroed
+    std::vector<char> zeros((size_t)off, 0);
+    f.write(zeros.data(), (std::streamsize)zeros.size());
+
+    writeAt(f, 0, &h, 1);
+    writeAt(f, h.roomsOffset, baked.rooms.data(), baked.rooms.size());
+    writeAt(f, h.furnitureOffset, baked.furniture.data(), baked.furniture.size());
+    writeAt(f, h.lightsOffset, baked.lights.data(), baked.lights.size());
+    writeAt(f, h.portalsOffset, baked.portals.data(), baked.portals.size());
+    writeAt(f, h.modelsOffset, boxes.models.data(), boxes.models.size());
+    writeAt(f, h.normalsOffset, boxes.normals.data(), boxes.normals.size());
+    writeAt(f, h.colorsOffset, boxes.colors.data(), boxes.colors.size());
+    return (bool)f;
+}
+
+// ---------------- binary loader ----------------
+bool MappedScene::open(const std::string& path, std::string& err) {
+    close();
+    if (!file.open(path, err)) return false;
+    base = file.data();
+    size = file.size();
+
+    // validate before anyone follows an offset
+    auto fits = [&](uint64_t offset, uint64_t count, size_t elem) {
+        return offset % 4 == 0 && offset <= size && count * elem <= size - offset;
+    };
+    const SceneBinHeader& h = header();
+    bool ok = size >= sizeof(SceneBinHeader) && std::memcmp(h.magic, "RSCN", 4) == 0;
+    if (ok && h.version != kSceneBinVersion) {
+        err = path + ": version " + std::to_string(h.version) + ", expected " + std::to_string(kSceneBinVersion);
+        close();
+        return false;
+    }
+    ok = ok &&
+        fits(h.roomsOffset, h.roomCount, sizeof(RoomDesc)) &&
+        fits(h.furnitureOffset, h.furnitureCount, sizeof(FurnitureDesc)) &&
+        fits(h.lightsOffset, h.lightCount, sizeof(LightDesc)) &&
+        fits(h.portalsOffset, h.portalCount, sizeof(PortalDesc)) &&
+        fits(h.modelsOffset, h.instanceCount, sizeof(glm::mat4)) &&
+        fits(h.normalsOffset, h.instanceCount, sizeof(glm::mat3)) &&
+        fits(h.colorsOffset, h.instanceCount, sizeof(glm::vec3));
+    for (uint32_t i = 0; ok && i < h.portalCount; ++i)
+        ok = portals()[i].roomA < h.roomCount && portals()[i].roomB < h.roomCount;
+    // every baked range inside the instance streams (written so it cannot
+    // overflow), every furniture type one emitFurniture knows
+    auto inStreams = [&](uint32_t first, uint32_t count) {
+        return first <= h.instanceCount && count <= h.instanceCount - first;
+    };
+    for (uint32_t i = 0; ok && i < h.roomCount; ++i)
+        ok = inStreams(rooms()[i].first, rooms()[i].count);
+    for (uint32_t i = 0; ok && i < h.furnitureCount; ++i) {
+        const FurnitureDesc& f = furniture()[i];
+        ok = inStreams(f.first, f.count) && (uint32_t)f.type <= (uint32_t)FurnitureType::Sofa;
+    }
+    if (!ok) {
+        err = path + ": not a valid scene binary";
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedScene::close() {
+    file.close();
+    base = nullptr;
+    size = 0;
+}
+
+void MappedScene::toDesc(SceneDesc& out) const {
+    const SceneBinHeader& h = header();
+    out.rooms.assign(rooms(), rooms() + h.roomCount);
+    out.furniture.assign(furniture(), furniture() + h.furnitureCount);
+    out.lights.assign(lights(), lights() + h.lightCount);
+    out.portals.assign(portals(), portals() + h.portalCount);
+}
@@ -0,0 +1,163 @@
+#pragma once
+// Scene description files.
+//
+// Text form (.scene), one record per line, '#' starts a comment:
+//   room         cx cy cz  width height depth  floorHex ceilHex backHex frontHex sideHex
+//   light        x y z  r g b  [radius]
+//   coffee_table x y z  yawDeg  [scale]
+//   tv_stand     x y z
+//   sofa         x y z  yawDeg
+//   box          x y z  sx sy sz  hex
+//   portal       roomA roomB  x0 y0 z0  x1 y1 z1
+//
+// A portal is a doorway between two rooms (0-based, in file order): an
+// axis-aligned opening from (x0,y0,z0) to (x1,y1,z1), flat along x or z and
+// lying in a wall both rooms share. The wall is built around the opening and
+// visibility flows from room to room only through portals.
+//
+// Binary form (.rscn) is what saveSceneBinary writes: a header, the records
+// above as fixed-size structs, then the baked per-instance streams (model
+// matrices, normal matrices, colors) laid out exactly like BoxBatch's GL
+// buffers. MappedScene memory-maps it, so loading is a validate + pointer
+// fix-up and the instance streams go to glBufferData straight from the map.
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+
+class BakedScene;
+
+struct RoomDesc {
+    glm::vec3 center;     // floor center
+    glm::vec3 size;       // width (x), height (y), depth (z)
+    glm::vec3 floorCol, ceilCol, backCol, frontCol, sideCol;
+    uint32_t first, count; // baked instance range (binary only)
+};
+
+enum class FurnitureType : uint32_t {
+    Box = 0,
+    CoffeeTable,
+    TVStand,
+    Sofa,          // last (MappedScene::open rejects anything past it)
+};
+
+// keyword used in the text form ("coffee_table", ...)
+const char* furnitureName(FurnitureType type);
+
+struct FurnitureDesc {
+    FurnitureType type;
+    glm::vec3 pos;
+    float yawDeg;
+    glm::vec3 scale;       // coffee table: global scale, box: size
+    glm::vec3 color;       // box only
+    uint32_t first, count; // baked instance range (binary only)
+};
+
+struct PortalDesc {
+    uint32_t roomA, roomB;
+    glm::vec3 min, max;    // opening; min == max along the wall normal
+};
+
+// point light; it fades out completely at `radius` (default kLightRadius),
+// which bounds the clusters it is assigned to (LightClusters.h)
+const float kLightRadius = 10.0f;
+
+struct LightDesc {
+    glm::vec3 pos;
+    glm::vec3 color;
+    float radius;
+};
+
+struct SceneDesc {
+    std::vector<RoomDesc> rooms;
+    std::vector<FurnitureDesc> furniture;
+    std::vector<LightDesc> lights;
+    std::vector<PortalDesc> portals;
+};
+
+// parse the text form; on failure returns false and sets err ("file:line: msg")
+bool parseSceneText(const char* text, size_t len, SceneDesc& out, std::string& err, const std::string& name = "scene");
+bool loadSceneText(const std::string& path, SceneDesc& out, std::string& err);
+
+// bake every record and write the binary form
+bool saveSceneBinary(const std::string& path, const SceneDesc& desc);
+
+// ---------------- binary layout ----------------
+const uint32_t kSceneBinVersion = 3;  // 2: portals, 3: light radius
+
+struct SceneBinHeader {
+    char magic[4];        // "RSCN"
+    uint32_t version;
+    uint32_t roomCount, furnitureCount, lightCount, instanceCount;
+    uint64_t roomsOffset, furnitureOffset, lightsOffset;
+    uint64_t modelsOffset, normalsOffset, colorsOffset;
+    uint32_t portalCount, pad;
+    uint64_t portalsOffset;
+};
+
+// read-only memory map of a .rscn file; records point into the mapping
+class MappedScene {
+public:
+    MappedScene() = default;
+    ~MappedScene() { close(); }
+    MappedScene(const MappedScene&) = delete;
+    MappedScene& operator=(const MappedScene&) = delete;
+
+    bool open(const std::string& path, std::string& err);
+    void close();
+    bool isOpen() const { return base != nullptr; }
+
+    const SceneBinHeader& header() const { return *(const SceneBinHeader*)base; }
+    const RoomDesc* rooms() const { return at<RoomDesc>(header().roomsOffset); }
+    const FurnitureDesc* furniture() const { return at<FurnitureDesc>(header().furnitureOffset); }
+    const LightDesc* lights() const { return at<LightDesc>(header().lightsOffset); }
+    const PortalDesc* portals() const { return at<PortalDesc>(header().portalsOffset); }
+    const glm::mat4* models() const { return at<glm::mat4>(header().modelsOffset); }
+    const glm::mat3* normals() const { return at<glm::mat3>(header().normalsOffset); }
+    const glm::vec3* colors() const { return at<glm::vec3>(header().colorsOffset); }
+
+    // copy the records (not the instances) into a SceneDesc
+    void toDesc(SceneDesc& out) const;
+
+private:
+    MappedFile file;
+    const unsigned char* base = nullptr;
+    size_t size = 0;
+
+    template <class T>
+    const T* at(uint64_t offset) const { return (const T*)(base + offset); }
+};
+
+// ---------------- scene -> BakedScene ----------------
+struct FurnitureContext;
+// a stretch of wall a room leaves out: axis 0 runs along x, 2 along z, at
+// `plane` on the other horizontal axis, from u0 to u1
+struct WallSpan {
+    int axis;
+    float plane, u0, u1;
+};
+
+// walls get an opening for every portal lying in them, and leave out the
+// `skip` spans (walls another room already builds)
+void emitRoom(const FurnitureContext& ctx, const RoomDesc& room,
+    const std::vector<PortalDesc>& portals = std::vector<PortalDesc>(),
+    const std::vector<WallSpan>& skip = std::vector<WallSpan>());
+void emitFurniture(const FurnitureContext& ctx, const FurnitureDesc& f);
+
+// portals that touch room `index`
+std::vector<PortalDesc> roomPortals(const std::vector<PortalDesc>& portals, uint32_t index);
+
+// the parts of room `index`'s walls that an earlier room shares (same plane,
+// at least as tall); a shared wall is built once, by the first room
+std::vector<WallSpan> sharedWalls(const std::vector<RoomDesc>& rooms, uint32_t index);
+
+// one BakedScene item per room/furniture record, rooms first (item i = room i)
+void populateScene(BakedScene& scene, const SceneDesc& desc);
+// same, but the instance buffer is filled straight from the mapping
+// (generators are kept so items can still be re-baked when marked dirty)
+void populateScene(BakedScene& scene, const MappedScene& mapped);
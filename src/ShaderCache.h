@@ -0,0 +1,130 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "GLExt.h"
+
+// Linked programs on disk, so a warm start skips GLSL compilation. A
+// program is stored as the driver's glGetProgramBinary blob under a key
+// hashed from both sources and the GL vendor / renderer / version strings;
+// a driver update or a shader edit just misses. A blob the driver refuses
+// anyway (glProgramBinary leaves the program unlinked) counts as rejected
+// and the caller compiles from source, which overwrites it.
+//
+// Off until open() names a directory, and without ARB_get_program_binary.
+class ShaderCache {
+public:
+    uint64_t hits = 0, misses = 0, rejected = 0;
+
+    // files go to `directory` (created on the first store)
+    void open(const std::string& directory) { dir = directory; }
+    void close() { dir.clear(); }
+    bool enabled() const { return !dir.empty() && GLExt::programBinary; }
+
+    // remove every stored program (benchmarks, a clean start)
+    void clear() {
+        std::error_code ec;
+        if (!dir.empty()) std::filesystem::remove_all(dir, ec);
+    }
+
+    // FNV-1a, 64 bit; needs a current context for the driver strings
+    uint64_t key(const std::string& vertex, const std::string& fragment) const {
+        uint64_t h = 14695981039346656037ull;
+        auto mix = [&h](const char* s, size_t n) {
+            for (size_t i = 0; i < n; ++i) {
+                h ^= (unsigned char)s[i];
+                h *= 1099511628211ull;
+            }
+            h ^= 0xff;   // separator, so "ab"+"c" != "a"+"bc"
+            h *= 1099511628211ull;
+        };
+        for (GLenum e : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+            const char* s = (const char*)glGetString(e);
+            mix(s ? s : "", s ? std::strlen(s) : 0);
+        }
+        mix(vertex.data(), vertex.size());
+        mix(fragment.data(), fragment.size());
+        return h;
+    }
+
+    // glProgramBinary the stored program; true if it is now linked
+    bool load(GLuint program, uint64_t k) {
+        const std::string file = path(k);
+        std::ifstream f(file, std::ios::binary);
+        FileHeader h{};
+        std::error_code ec;
+        if (!f || !f.read((char*)&h, sizeof(h)) || h.magic != kMagic || h.key != k ||
+            sizeof(h) + h.length > std::filesystem::file_size(file, ec)) { ++misses; return false; }
+        std::vector<char> blob(h.length);
+        if (!f.read(blob.data(), (std::streamsize)blob.size())) { ++misses; return false; }
+
+        GLExt::ProgramBinary(program, h.format, blob.data(), (GLsizei)blob.size());
+        GLint linked = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked) { ++rejected; return false; }
+        ++hits;
+        return true;
+    }
+
+    // before glLinkProgram, so the driver keeps the binary around
+    static void markRetrievable(GLuint program) {
+        GLExt::ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    // store a linked program; written to a temporary and renamed, so a
+    // reader never sees half a file
+    void store(GLuint program, uint64_t k) {
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) return;
+        std::vector<char> blob((size_t)length);
+        FileHeader h{ kMagic, 0, k, 0 };
+        GLsizei written = 0;
+        GLExt::GetProgramBinary(program, length, &written, &h.format, blob.data());
+        h.length = (uint32_t)written;
+
+        std::error_code ec;
+        std::filesystem::create_directories(dir, ec);
+        const std::string out = path(k), tmp = out + ".tmp";
+        {
+            std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+            if (!f) return;
+            f.write((const char*)&h, sizeof(h));
+            f.write(blob.data(), written);
+            if (!f) return;
+        }
+        std::filesystem::rename(tmp, out, ec);
+    }
+
+private:
+    static const uint32_t kMagic = 0x47525052;   // "RPRG"
+
+    struct FileHeader {
+        uint32_t magic;
+        GLenum format;
+        uint64_t key;
+        uint32_t length;
+    };
+
+    std::string dir;
+
+    std::string path(uint64_t k) const {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)k);
+        return dir + "/" + name;
+    }
+};
+
+inline ShaderCache& shaderCache() {
+    static ShaderCache cache;
+    return cache;
+}
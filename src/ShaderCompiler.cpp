@@ -0,0 +1,112 @@
+#include "ShaderCompiler.h"
+
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+
+#include "CpuProfiler.h"
+#include "shader.h"
+
+ShaderCompiler::ShaderCompiler(GLFWwindow* share) {
+    // the current hints (version, profile) still hold from the main window
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    context = glfwCreateWindow(1, 1, "shader compiler", nullptr, share);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+    if (!context) {
+        std::cerr << "ShaderCompiler: no shared context, reloads compile on the render thread\n";
+        return;
+    }
+    ok = true;
+    thread = std::thread([this] { run(); });
+}
+
+ShaderCompiler::~ShaderCompiler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_all();
+    if (thread.joinable()) thread.join();
+    for (auto& r : results)
+        if (r.second.program) glState().deleteProgram(r.second.program);
+    if (context) glfwDestroyWindow(context);
+}
+
+uint64_t ShaderCompiler::submit(const std::string& vertex, const std::string& fragment, bool retrievable) {
+    uint64_t id;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        id = nextJob++;
+        jobs.push_back(Job{ id, vertex, fragment, retrievable });
+    }
+    wake.notify_one();
+    return id;
+}
+
+bool ShaderCompiler::done(uint64_t job) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return results.count(job) != 0;
+}
+
+GLuint ShaderCompiler::wait(uint64_t job, bool& linked) {
+    std::unique_lock<std::mutex> lock(mutex);
+    built.wait(lock, [&] { return results.count(job) != 0 || quit; });
+    auto it = results.find(job);
+    if (it == results.end()) { linked = false; return 0; }
+    const Result r = it->second;
+    results.erase(it);
+    linked = r.linked;
+    return r.program;
+}
+
+void ShaderCompiler::cancel(uint64_t job) {
+    GLuint program = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = jobs.begin(); it != jobs.end(); ++it) {
+            if (it->id != job) continue;
+            jobs.erase(it);
+            return;
+        }
+        auto it = results.find(job);
+        if (it == results.end()) {
+            cancelled.insert(job);
+            return;
+        }
+        program = it->second.program;
+        results.erase(it);
+    }
+    if (program) glState().deleteProgram(program);
+}
+
+void ShaderCompiler::run() {
+    PROFILE_THREAD("shader compile");
+    glfwMakeContextCurrent(context);
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return quit || !jobs.empty(); });
+            if (quit) break;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        const GLuint program = glCreateProgram();
+        bool linked;
+        {
+            PROFILE_SCOPE("build program");
+            linked = Shader::build(program, job.vertex, job.fragment, job.retrievable);
+            glFinish();   // complete before the render thread uses it
+        }
+        bool drop;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            drop = cancelled.erase(job.id) != 0;
+            if (!drop) results.emplace(job.id, Result{ program, linked });
+        }
+        // never seen by the render thread, so not in its GLState either
+        if (drop) glDeleteProgram(program);
+        else built.notify_all();
+    }
+    glfwMakeContextCurrent(nullptr);
+}
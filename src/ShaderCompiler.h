@@ -0,0 +1,72 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+struct GLFWwindow;
+
+// Compiles and links programs on a background thread that has its own GL
+// context, shared with the render thread's, so a shader reload does not
+// stall the frame on a driver without KHR_parallel_shader_compile (there
+// glLinkProgram and the status queries block until the program is built).
+// Shader uses it for programs built with wait = false; see Shader::ready.
+//
+// The worker creates the program itself and hands over its name once
+// the program is linked and glFinish has flushed it, so the render
+// thread only reflects uniforms. Construct and destroy on the render
+// thread (GLFW creates windows there); a program still being built at
+// destruction is waited for.
+class ShaderCompiler {
+public:
+    explicit ShaderCompiler(GLFWwindow* share);
+    ~ShaderCompiler();
+    ShaderCompiler(const ShaderCompiler&) = delete;
+    ShaderCompiler& operator=(const ShaderCompiler&) = delete;
+
+    // false if no shared context could be made (Shader then compiles on
+    // the render thread as before)
+    bool running() const { return ok; }
+
+    // queue a program; `retrievable` sets the binary hint for ShaderCache
+    uint64_t submit(const std::string& vertex, const std::string& fragment, bool retrievable);
+
+    bool done(uint64_t job);
+    // the job's program (0 if none was made) and whether it linked; blocks
+    // until it is built
+    GLuint wait(uint64_t job, bool& linked);
+    // the program is deleted whenever it is built; no wait
+    void cancel(uint64_t job);
+
+private:
+    struct Job {
+        uint64_t id;
+        std::string vertex, fragment;
+        bool retrievable;
+    };
+    struct Result {
+        GLuint program;
+        bool linked;
+    };
+
+    GLFWwindow* context = nullptr;
+    bool ok = false;
+
+    std::mutex mutex;
+    std::condition_variable wake, built;
+    std::deque<Job> jobs;
+    std::unordered_map<uint64_t, Result> results;
+    std::unordered_set<uint64_t> cancelled;   // being built; dropped when done
+    uint64_t nextJob = 1;
+    bool quit = false;
+    std::thread thread;
+
+    void run();
+};
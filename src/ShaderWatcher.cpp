@@ -0,0 +1,134 @@
+#include "ShaderWatcher.h"
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <system_error>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+bool isShaderSource(const std::string& name) {
+    for (const char* ext : { ".vert", ".frag", ".glsl" }) {
+        const std::string e = ext;
+        if (name.size() > e.size() && name.compare(name.size() - e.size(), e.size(), e) == 0) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+ShaderWatcher::ShaderWatcher(const std::string& directory) : dir(directory) {
+#ifdef __linux__
+    notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (notifyFd < 0 || pipe2(wakePipe, O_CLOEXEC) != 0 ||
+        inotify_add_watch(notifyFd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+        std::cerr << "ShaderWatcher: cannot watch " << dir << "\n";
+        return;
+    }
+#else
+    std::error_code ec;
+    if (!std::filesystem::is_directory(dir, ec)) {
+        std::cerr << "ShaderWatcher: cannot watch " << dir << "\n";
+        return;
+    }
+#endif
+    ok = true;
+    thread = std::thread([this] { run(); });
+}
+
+ShaderWatcher::~ShaderWatcher() {
+    quit = true;
+#ifdef __linux__
+    if (wakePipe[1] >= 0) {
+        const char c = 0;
+        (void)!write(wakePipe[1], &c, 1);
+    }
+#else
+    {
+        // taken so the notify cannot slip in between run()'s check and its wait
+        std::lock_guard<std::mutex> lock(mutex);
+    }
+    wake.notify_all();
+#endif
+    if (thread.joinable()) thread.join();
+#ifdef __linux__
+    for (int fd : { notifyFd, wakePipe[0], wakePipe[1] })
+        if (fd >= 0) ::close(fd);
+#endif
+}
+
+std::vector<std::string> ShaderWatcher::takeChanged() {
+    if (!any.load(std::memory_order_acquire)) return {};
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::string> out(changed.begin(), changed.end());
+    changed.clear();
+    any = false;
+    return out;
+}
+
+void ShaderWatcher::note(const std::string& name) {
+    if (!isShaderSource(name)) return;   // editor swap / backup files
+    std::lock_guard<std::mutex> lock(mutex);
+    changed.insert(name);
+    any.store(true, std::memory_order_release);
+}
+
+#ifdef __linux__
+
+void ShaderWatcher::run() {
+    alignas(inotify_event) char buf[4096];
+    pollfd fds[2] = { { notifyFd, POLLIN, 0 }, { wakePipe[0], POLLIN, 0 } };
+    while (!quit) {
+        if (poll(fds, 2, -1) < 0) continue;   // EINTR
+        if (fds[1].revents) break;
+        for (;;) {
+            const ssize_t n = read(notifyFd, buf, sizeof(buf));
+            if (n <= 0) break;   // EAGAIN: drained
+            for (ssize_t off = 0; off < n;) {
+                const inotify_event* e = (const inotify_event*)(buf + off);
+                if (e->len > 0 && !(e->mask & IN_ISDIR)) note(e->name);
+                off += (ssize_t)(sizeof(inotify_event) + e->len);
+            }
+        }
+    }
+}
+
+#else
+
+void ShaderWatcher::run() {
+    namespace fs = std::filesystem;
+    std::map<std::string, fs::file_time_type> seen;
+    bool first = true;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!quit) {
+        lock.unlock();
+        std::error_code ec;
+        for (const fs::directory_entry& e : fs::directory_iterator(dir, ec)) {
+            const std::string name = e.path().filename().string();
+            const fs::file_time_type t = e.last_write_time(ec);
+            if (ec) continue;
+            auto it = seen.find(name);
+            if (it == seen.end()) {
+                seen.emplace(name, t);
+                if (!first) note(name);
+            }
+            else if (it->second != t) {
+                it->second = t;
+                note(name);
+            }
+        }
+        first = false;
+        lock.lock();
+        wake.wait_for(lock, std::chrono::milliseconds(250), [this] { return quit.load(); });
+    }
+}
+
+#endif
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Watches a directory for edited shader sources (.vert / .frag / .glsl) on a
+// background thread: inotify on Linux (the thread sleeps in poll until the
+// kernel reports a write or a rename into the directory, so editors that
+// save through a temporary file are seen too), elsewhere a scan of the
+// modification times four times a second. The render loop calls
+// takeChanged() once a frame, which costs an atomic load when nothing
+// changed, and hands the names to RoomRenderer::updateShaders.
+class ShaderWatcher {
+public:
+    explicit ShaderWatcher(const std::string& directory);
+    ~ShaderWatcher();
+    ShaderWatcher(const ShaderWatcher&) = delete;
+    ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+    // false if the directory could not be watched (nothing will be reported)
+    bool watching() const { return ok; }
+
+    // file names (no directory) changed since the last call, each once
+    std::vector<std::string> takeChanged();
+
+private:
+    std::string dir;
+    bool ok = false;
+
+    std::mutex mutex;
+    std::set<std::string> changed;
+    std::atomic<bool> any{ false };
+
+    std::atomic<bool> quit{ false };
+    std::condition_variable wake;   // polling fallback
+#ifdef __linux__
+    int notifyFd = -1;
+    int wakePipe[2] = { -1, -1 };   // written on quit, so poll returns at once
+#endif
+    std::thread thread;
+
+    void run();
+    void note(const std::string& name);
+};
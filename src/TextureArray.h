@@ -0,0 +1,76 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "GLState.h"
+#include "TextureFile.h"
+#include "TextureLoader.h"
+
+// Material images packed into one GL_TEXTURE_2D_ARRAY, one image per layer,
+// all resampled to layerSize x layerSize. Boxes pick their layer and UV
+// transform per instance (BoxMaterial), so textured and plain boxes stay in
+// the same instanced draw with nothing bound in between. A layer per image
+// (rather than a 2D atlas) keeps GL_REPEAT tiling and the mip chain free of
+// bleeding between neighbours, so no padding is needed.
+//
+// add() the paths, then build() with a GL context; the array lives on
+// kTextureUnit from then on. The images come in through a TextureLoader
+// (decoded on its workers, uploaded within its per-frame budget), so a
+// layer is plain white until its image is in, and stays white if it fails
+// to load. A cooked .rtex next to a source is used instead of decoding it.
+class TextureArray {
+public:
+    static const GLuint kTextureUnit = 7;   // after LightClusters' 4..6
+
+    explicit TextureArray(int layerSize = 512) : layerSize(layerSize) {}
+    ~TextureArray() { if (texture) glState().deleteTextures(1, &texture); }
+    TextureArray(const TextureArray&) = delete;
+    TextureArray& operator=(const TextureArray&) = delete;
+
+    // layer of a material image; the same path gets the same layer
+    int add(const std::string& path) {
+        for (size_t i = 0; i < paths.size(); ++i)
+            if (paths[i] == path) return (int)i;
+        paths.push_back(path);
+        return (int)paths.size() - 1;
+    }
+
+    size_t layers() const { return paths.size(); }
+
+    // (re)create the array with every layer white and ask `loader` for the
+    // images. With no images at all the array still has one white layer,
+    // so the sampler is always complete. Reallocating drops what was
+    // loaded, so a rebuild requests every layer again.
+    void build(TextureLoader& loader) {
+        const int count = std::max<int>(1, (int)paths.size());
+        if (!texture) glGenTextures(1, &texture);
+        glState().bindTexture(kTextureUnit, GL_TEXTURE_2D_ARRAY, texture);
+        glState().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);   // the placeholder comes from client memory
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, layerSize, layerSize, count, 0,
+            GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        const std::vector<uint8_t> white((size_t)layerSize * layerSize * 4, 255);
+        for (int i = 0; i < count; ++i)
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, layerSize, layerSize, 1,
+                GL_RGBA, GL_UNSIGNED_BYTE, white.data());
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+        for (size_t i = 0; i < paths.size(); ++i)
+            loader.requestLayer(cookedTexturePath(paths[i]), texture, (int)i, layerSize);
+    }
+
+    void bind() const { glState().bindTexture(kTextureUnit, GL_TEXTURE_2D_ARRAY, texture); }
+
+private:
+    int layerSize;
+    std::vector<std::string> paths;
+    GLuint texture = 0;
+};
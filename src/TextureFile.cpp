@@ -0,0 +1,399 @@
+#include "TextureFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+const char* textureFormatName(TextureFormat format) {
+    switch (format) {
+    case TextureFormat::RGBA8: return "rgba8";
+    case TextureFormat::BC1: return "bc1";
+    case TextureFormat::BC3: return "bc3";
+    }
+    return "?";
+}
+
+size_t textureBlockBytes(TextureFormat format) {
+    switch (format) {
+    case TextureFormat::BC1: return 8;
+    case TextureFormat::BC3: return 16;
+    default: return 0;
+    }
+}
+
+size_t textureLevelBytes(TextureFormat format, int width, int height) {
+    if (format == TextureFormat::RGBA8) return (size_t)width * height * 4;
+    return (size_t)std::max(1, (width + 3) / 4) * std::max(1, (height + 3) / 4) * textureBlockBytes(format);
+}
+
+void halveImage(std::vector<uint8_t>& pixels, int& width, int& height) {
+    const int w = width, h = height;
+    const int nw = std::max(1, w / 2), nh = std::max(1, h / 2);
+    std::vector<uint8_t> out((size_t)nw * nh * 4);
+    // source span of output texel i: 2i and 2i+1, and for the last one
+    // whatever is left (a third row / column when odd, itself when 1 wide)
+    auto span = [](int i, int n, int size, int& first, int& last) {
+        first = std::min(2 * i, size - 1);
+        last = i == n - 1 ? size - 1 : 2 * i + 1;
+    };
+    for (int y = 0; y < nh; ++y) {
+        int y0, y1;
+        span(y, nh, h, y0, y1);
+        const uint8_t* r0 = &pixels[(size_t)y0 * w * 4];
+        const uint8_t* r1 = &pixels[(size_t)std::min(y0 + 1, h - 1) * w * 4];
+        uint8_t* dst = &out[(size_t)y * nw * 4];
+        for (int x = 0; x < nw; ++x) {
+            int x0, x1;
+            span(x, nw, w, x0, x1);
+            if (x1 == x0 + 1 && y1 == y0 + 1) {
+                for (int c = 0; c < 4; ++c)
+                    dst[x * 4 + c] = (uint8_t)((r0[x0 * 4 + c] + r0[x1 * 4 + c] + r1[x0 * 4 + c] + r1[x1 * 4 + c] + 2) / 4);
+                continue;
+            }
+            const int n = (y1 - y0 + 1) * (x1 - x0 + 1);
+            for (int c = 0; c < 4; ++c) {
+                int sum = 0;
+                for (int sy = y0; sy <= y1; ++sy)
+                    for (int sx = x0; sx <= x1; ++sx) sum += pixels[((size_t)sy * w + sx) * 4 + c];
+                dst[x * 4 + c] = (uint8_t)((sum + n / 2) / n);
+            }
+        }
+    }
+    pixels.swap(out);
+    width = nw;
+    height = nh;
+}
+
+void resampleImage(const std::vector<uint8_t>& pixels, int width, int height, int size, std::vector<uint8_t>& out) {
+    const int w = width, h = height;
+    out.resize((size_t)size * size * 4);
+    const float sx = (float)w / size, sy = (float)h / size;
+    for (int y = 0; y < size; ++y) {
+        const float fy = std::max(0.0f, (y + 0.5f) * sy - 0.5f);
+        const int y0 = std::min((int)fy, h - 1), y1 = std::min(y0 + 1, h - 1);
+        const float ty = fy - (float)y0;
+        for (int x = 0; x < size; ++x) {
+            const float fx = std::max(0.0f, (x + 0.5f) * sx - 0.5f);
+            const int x0 = std::min((int)fx, w - 1), x1 = std::min(x0 + 1, w - 1);
+            const float tx = fx - (float)x0;
+            for (int c = 0; c < 4; ++c) {
+                auto at = [&](int px, int py) { return (float)pixels[((size_t)py * w + px) * 4 + c]; };
+                const float top = at(x0, y0) + (at(x1, y0) - at(x0, y0)) * tx;
+                const float bottom = at(x0, y1) + (at(x1, y1) - at(x0, y1)) * tx;
+                out[((size_t)y * size + x) * 4 + c] = (uint8_t)(top + (bottom - top) * ty + 0.5f);
+            }
+        }
+    }
+}
+
+// ---------------- BC1 / BC3 ----------------
+namespace {
+
+uint16_t to565(const float* c) {
+    auto q = [](float v, int bits) {
+        const int top = (1 << bits) - 1;
+        return (uint16_t)std::min(top, std::max(0, (int)std::lround(v * top / 255.0f)));
+    };
+    return (uint16_t)(q(c[0], 5) << 11 | q(c[1], 6) << 5 | q(c[2], 5));
+}
+
+void from565(uint16_t v, int* c) {
+    const int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+    c[0] = r << 3 | r >> 2;
+    c[1] = g << 2 | g >> 4;
+    c[2] = b << 3 | b >> 2;
+}
+
+// the four colors a BC1 block can pick from
+void colorPalette(uint16_t c0, uint16_t c1, bool fourColor, int pal[4][3]) {
+    from565(c0, pal[0]);
+    from565(c1, pal[1]);
+    for (int c = 0; c < 3; ++c) {
+        if (fourColor) {
+            pal[2][c] = (2 * pal[0][c] + pal[1][c]) / 3;
+            pal[3][c] = (pal[0][c] + 2 * pal[1][c]) / 3;
+        } else {
+            pal[2][c] = (pal[0][c] + pal[1][c]) / 2;
+            pal[3][c] = 0;
+        }
+    }
+}
+
+void alphaPalette(int a0, int a1, int pal[8]) {
+    pal[0] = a0;
+    pal[1] = a1;
+    if (a0 > a1) {
+        for (int i = 2; i < 8; ++i) pal[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+    } else {
+        for (int i = 2; i < 6; ++i) pal[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+        pal[6] = 0;
+        pal[7] = 255;
+    }
+}
+
+void put16(uint8_t* p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+uint16_t get16(const uint8_t* p) { return (uint16_t)(p[0] | p[1] << 8); }
+
+// Endpoints on the principal axis of the block's colors (a few power
+// iterations of the covariance), pulled in by 1/16 of the range, which
+// trades a little range for less error on the in-between texels. The
+// iteration starts from the covariance row of the channel that varies most:
+// a fixed grey (1,1,1) start is orthogonal to the axis of a hue-only block
+// (red / green at equal brightness) and never leaves zero
+void encodeColor(const uint8_t* rgba, uint8_t* out) {
+    float mean[3] = { 0, 0, 0 };
+    for (int i = 0; i < 16; ++i)
+        for (int c = 0; c < 3; ++c) mean[c] += rgba[i * 4 + c];
+    for (float& m : mean) m /= 16.0f;
+
+    float cov[3][3] = {};
+    for (int i = 0; i < 16; ++i) {
+        float d[3];
+        for (int c = 0; c < 3; ++c) d[c] = rgba[i * 4 + c] - mean[c];
+        for (int a = 0; a < 3; ++a)
+            for (int b = 0; b < 3; ++b) cov[a][b] += d[a] * d[b];
+    }
+    int k = 0;
+    for (int a = 1; a < 3; ++a)
+        if (cov[a][a] > cov[k][k]) k = a;
+    float axis[3] = { cov[k][0], cov[k][1], cov[k][2] };
+    bool found = false;
+    for (int it = 0; it < 4; ++it) {
+        float v[3];
+        for (int a = 0; a < 3; ++a) v[a] = cov[a][0] * axis[0] + cov[a][1] * axis[1] + cov[a][2] * axis[2];
+        const float len = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+        if (len < 1e-4f) break;
+        for (int a = 0; a < 3; ++a) axis[a] = v[a] / len;
+        found = true;
+    }
+    if (!found) {
+        // no spread for the iteration to find: the bounding box diagonal,
+        // or any axis at all for a flat block
+        float lo[3] = { 255, 255, 255 }, hi[3] = { 0, 0, 0 };
+        for (int i = 0; i < 16; ++i)
+            for (int c = 0; c < 3; ++c) {
+                lo[c] = std::min(lo[c], (float)rgba[i * 4 + c]);
+                hi[c] = std::max(hi[c], (float)rgba[i * 4 + c]);
+            }
+        const float d[3] = { hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2] };
+        const float len = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+        for (int c = 0; c < 3; ++c) axis[c] = len > 0.0f ? d[c] / len : 0.577f;
+    }
+
+    float lo = 1e30f, hi = -1e30f;
+    for (int i = 0; i < 16; ++i) {
+        float t = 0.0f;
+        for (int c = 0; c < 3; ++c) t += (rgba[i * 4 + c] - mean[c]) * axis[c];
+        lo = std::min(lo, t);
+        hi = std::max(hi, t);
+    }
+    const float inset = (hi - lo) / 16.0f;
+    lo += inset;
+    hi -= inset;
+    float e0[3], e1[3];
+    for (int c = 0; c < 3; ++c) {
+        e0[c] = mean[c] + axis[c] * hi;
+        e1[c] = mean[c] + axis[c] * lo;
+    }
+    uint16_t c0 = to565(e0), c1 = to565(e1);
+    if (c0 < c1) std::swap(c0, c1);   // c0 > c1 selects the four-color mode
+
+    uint32_t indices = 0;
+    if (c0 != c1) {
+        int pal[4][3];
+        colorPalette(c0, c1, true, pal);
+        for (int i = 0; i < 16; ++i) {
+            int best = 0, bestErr = 1 << 30;
+            for (int p = 0; p < 4; ++p) {
+                int err = 0;
+                for (int c = 0; c < 3; ++c) {
+                    const int d = rgba[i * 4 + c] - pal[p][c];
+                    err += d * d;
+                }
+                if (err < bestErr) { bestErr = err; best = p; }
+            }
+            indices |= (uint32_t)best << (2 * i);
+        }
+    }
+    put16(out, c0);
+    put16(out + 2, c1);
+    for (int b = 0; b < 4; ++b) out[4 + b] = (uint8_t)(indices >> (8 * b));
+}
+
+void decodeColor(const uint8_t* block, uint8_t* rgba, bool forceFourColor) {
+    const uint16_t c0 = get16(block), c1 = get16(block + 2);
+    const bool fourColor = forceFourColor || c0 > c1;
+    int pal[4][3];
+    colorPalette(c0, c1, fourColor, pal);
+    const uint32_t indices = block[4] | block[5] << 8 | block[6] << 16 | (uint32_t)block[7] << 24;
+    for (int i = 0; i < 16; ++i) {
+        const int p = (indices >> (2 * i)) & 3;
+        for (int c = 0; c < 3; ++c) rgba[i * 4 + c] = (uint8_t)pal[p][c];
+        rgba[i * 4 + 3] = (!fourColor && p == 3) ? 0 : 255;
+    }
+}
+
+} // namespace
+
+void encodeBC1Block(const uint8_t* rgba, uint8_t* out) {
+    encodeColor(rgba, out);
+}
+
+void encodeBC3Block(const uint8_t* rgba, uint8_t* out) {
+    int a0 = 0, a1 = 255;
+    for (int i = 0; i < 16; ++i) {
+        a0 = std::max(a0, (int)rgba[i * 4 + 3]);
+        a1 = std::min(a1, (int)rgba[i * 4 + 3]);
+    }
+    uint64_t indices = 0;
+    if (a0 != a1) {
+        int pal[8];
+        alphaPalette(a0, a1, pal);
+        for (int i = 0; i < 16; ++i) {
+            int best = 0, bestErr = 1 << 30;
+            for (int p = 0; p < 8; ++p) {
+                const int err = std::abs(rgba[i * 4 + 3] - pal[p]);
+                if (err < bestErr) { bestErr = err; best = p; }
+            }
+            indices |= (uint64_t)best << (3 * i);
+        }
+    }
+    out[0] = (uint8_t)a0;
+    out[1] = (uint8_t)a1;
+    for (int b = 0; b < 6; ++b) out[2 + b] = (uint8_t)(indices >> (8 * b));
+    encodeColor(rgba, out + 8);
+}
+
+void decodeBC1Block(const uint8_t* block, uint8_t* rgba) {
+    decodeColor(block, rgba, false);
+}
+
+void decodeBC3Block(const uint8_t* block, uint8_t* rgba) {
+    decodeColor(block + 8, rgba, true);
+    int pal[8];
+    alphaPalette(block[0], block[1], pal);
+    uint64_t indices = 0;
+    for (int b = 0; b < 6; ++b) indices |= (uint64_t)block[2 + b] << (8 * b);
+    for (int i = 0; i < 16; ++i) rgba[i * 4 + 3] = (uint8_t)pal[(indices >> (3 * i)) & 7];
+}
+
+void encodeBlockRow(TextureFormat format, const uint8_t* rgba, int width, int height, int row, uint8_t* out) {
+    const size_t blockBytes = textureBlockBytes(format);
+    const int blocks = std::max(1, (width + 3) / 4);
+    uint8_t texels[64];
+    for (int bx = 0; bx < blocks; ++bx) {
+        for (int y = 0; y < 4; ++y) {
+            const uint8_t* src = rgba + (size_t)std::min(row * 4 + y, height - 1) * width * 4;
+            for (int x = 0; x < 4; ++x)
+                std::memcpy(&texels[(y * 4 + x) * 4], src + std::min(bx * 4 + x, width - 1) * 4, 4);
+        }
+        if (format == TextureFormat::BC1) encodeBC1Block(texels, out + bx * blockBytes);
+        else encodeBC3Block(texels, out + bx * blockBytes);
+    }
+}
+
+void decodeTextureLevel(TextureFormat format, const uint8_t* blocks, int width, int height, std::vector<uint8_t>& rgba) {
+    rgba.resize((size_t)width * height * 4);
+    if (format == TextureFormat::RGBA8) {
+        std::memcpy(rgba.data(), blocks, rgba.size());
+        return;
+    }
+    const size_t blockBytes = textureBlockBytes(format);
+    const int bw = std::max(1, (width + 3) / 4), bh = std::max(1, (height + 3) / 4);
+    uint8_t texels[64];
+    for (int by = 0; by < bh; ++by)
+        for (int bx = 0; bx < bw; ++bx) {
+            const uint8_t* block = blocks + ((size_t)by * bw + bx) * blockBytes;
+            if (format == TextureFormat::BC1) decodeBC1Block(block, texels);
+            else decodeBC3Block(block, texels);
+            for (int y = 0; y < 4 && by * 4 + y < height; ++y)
+                for (int x = 0; x < 4 && bx * 4 + x < width; ++x)
+                    std::memcpy(&rgba[((size_t)(by * 4 + y) * width + bx * 4 + x) * 4], &texels[(y * 4 + x) * 4], 4);
+        }
+}
+
+// ---------------- binary writer ----------------
+namespace {
+
+uint64_t align16(uint64_t v) { return (v + 15) & ~uint64_t(15); }
+
+} // namespace
+
+bool saveTextureBinary(const std::string& path, TextureFormat format, const std::vector<TextureLevelData>& levels) {
+    if (levels.empty()) return false;
+    TextureBinHeader h{};
+    std::memcpy(h.magic, "RTEX", 4);
+    h.version = kTextureBinVersion;
+    h.format = format;
+    h.width = (uint32_t)levels[0].width;
+    h.height = (uint32_t)levels[0].height;
+    h.levelCount = (uint32_t)levels.size();
+    h.levelsOffset = align16(sizeof(TextureBinHeader));
+
+    std::vector<TextureLevelDesc> table(levels.size());
+    uint64_t off = align16(h.levelsOffset + table.size() * sizeof(TextureLevelDesc));
+    for (size_t i = 0; i < levels.size(); ++i) {
+        table[i] = TextureLevelDesc{ (uint32_t)levels[i].width, (uint32_t)levels[i].height, off, levels[i].data.size() };
+        off = align16(off + levels[i].data.size());
+    }
+
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    if (!f) return false;
+    // sections in file order, zero padding in between
+    const char zeros[16] = {};
+    uint64_t at = 0;
+    auto write = [&](uint64_t offset, const void* data, size_t bytes) {
+        f.write(zeros, (std::streamsize)(offset - at));
+        f.write((const char*)data, (std::streamsize)bytes);
+        at = offset + bytes;
+    };
+    write(0, &h, sizeof(h));
+    write(h.levelsOffset, table.data(), table.size() * sizeof(TextureLevelDesc));
+    for (size_t i = 0; i < levels.size(); ++i) write(table[i].offset, levels[i].data.data(), levels[i].data.size());
+    return (bool)f;
+}
+
+// ---------------- binary loader ----------------
+bool MappedTexture::open(const std::string& path, std::string& err) {
+    if (!file.open(path, err)) return false;
+
+    // validate before anyone follows an offset
+    const size_t size = file.size();
+    auto fits = [&](uint64_t offset, uint64_t bytes) {
+        return offset % 4 == 0 && offset <= size && bytes <= size - offset;
+    };
+    const TextureBinHeader& h = header();
+    bool ok = size >= sizeof(TextureBinHeader) && std::memcmp(h.magic, "RTEX", 4) == 0;
+    if (ok && h.version != kTextureBinVersion) {
+        err = path + ": version " + std::to_string(h.version) + ", expected " + std::to_string(kTextureBinVersion);
+        close();
+        return false;
+    }
+    ok = ok && h.format <= TextureFormat::BC3 && h.levelCount >= 1 && h.levelCount <= 32 &&
+        fits(h.levelsOffset, (uint64_t)h.levelCount * sizeof(TextureLevelDesc));
+    for (uint32_t i = 0; ok && i < h.levelCount; ++i) {
+        const TextureLevelDesc& l = level(i);
+        ok = l.width == std::max(1u, h.width >> i) && l.height == std::max(1u, h.height >> i) &&
+            l.size == textureLevelBytes(h.format, (int)l.width, (int)l.height) && fits(l.offset, l.size);
+    }
+    if (!ok) {
+        err = path + ": not a valid cooked texture";
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedTexture::close() {
+    file.close();
+}
+
+std::string cookedTexturePath(const std::string& source) {
+    const size_t slash = source.find_last_of("/\\");
+    const size_t dot = source.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return source;
+    const std::string cooked = source.substr(0, dot) + ".rtex";
+    return std::ifstream(cooked, std::ios::binary).good() ? cooked : source;
+}
@@ -0,0 +1,94 @@
+#pragma once
+// Cooked textures (.rtex), written by tools/texture_cook and loaded by
+// TextureLoader. Like a KTX2 file without the generality: a header, a table
+// of mip levels, then each level's data exactly as glCompressedTexImage2D
+// (BC1 / BC3) or glTexImage2D (RGBA8) takes it, level 0 first, rows bottom
+// up. MappedTexture memory-maps it, so loading is a validate and the levels
+// are uploaded straight from the map; no decode, no GPU mip generation.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+
+enum class TextureFormat : uint32_t {
+    RGBA8 = 0,
+    BC1,   // DXT1: RGB, 4 bits a texel
+    BC3,   // DXT5: BC1 color + interpolated alpha, 8 bits a texel
+};
+
+// "rgba8", "bc1", "bc3"
+const char* textureFormatName(TextureFormat format);
+
+// bytes of a 4x4 block (0 for RGBA8) and of a whole level
+size_t textureBlockBytes(TextureFormat format);
+size_t textureLevelBytes(TextureFormat format, int width, int height);
+
+// ---------------- CPU image helpers (RGBA8, tightly packed) ----------------
+// 2x2 box filter; with an odd size the last row / column is folded into
+// the texels next to it (3 wide there), so no source texel is dropped
+void halveImage(std::vector<uint8_t>& pixels, int& width, int& height);
+// bilinear, texel centers to texel centers, to size x size; halveImage
+// the source down first while it is twice that or more, or texels get skipped
+void resampleImage(const std::vector<uint8_t>& pixels, int width, int height, int size, std::vector<uint8_t>& out);
+
+// one 4x4 block, texels row by row (64 bytes in); BC1 always uses the
+// four-color mode, so it is also the color half of BC3
+void encodeBC1Block(const uint8_t* rgba, uint8_t* out);
+void encodeBC3Block(const uint8_t* rgba, uint8_t* out);
+void decodeBC1Block(const uint8_t* block, uint8_t* rgba);
+void decodeBC3Block(const uint8_t* block, uint8_t* rgba);
+
+// block row `row` (texel rows 4*row .. 4*row+3, edges clamped) of a level
+// into `out`, which points at that row's first block
+void encodeBlockRow(TextureFormat format, const uint8_t* rgba, int width, int height, int row, uint8_t* out);
+// a whole BC level back to RGBA8 (for GL drivers without S3TC, and to
+// measure the error)
+void decodeTextureLevel(TextureFormat format, const uint8_t* blocks, int width, int height, std::vector<uint8_t>& rgba);
+
+// ---------------- binary layout ----------------
+const uint32_t kTextureBinVersion = 1;
+
+struct TextureBinHeader {
+    char magic[4];        // "RTEX"
+    uint32_t version;
+    TextureFormat format;
+    uint32_t width, height;
+    uint32_t levelCount;
+    uint64_t levelsOffset; // TextureLevelDesc[levelCount]
+};
+
+struct TextureLevelDesc {
+    uint32_t width, height;
+    uint64_t offset, size;
+};
+
+struct TextureLevelData {
+    int width, height;
+    std::vector<uint8_t> data;   // textureLevelBytes(format, width, height)
+};
+
+bool saveTextureBinary(const std::string& path, TextureFormat format, const std::vector<TextureLevelData>& levels);
+
+// read-only memory map of a .rtex file
+class MappedTexture {
+public:
+    bool open(const std::string& path, std::string& err);
+    void close();
+    bool isOpen() const { return file.isOpen(); }
+
+    const TextureBinHeader& header() const { return *(const TextureBinHeader*)file.data(); }
+    const TextureLevelDesc& level(uint32_t i) const {
+        return ((const TextureLevelDesc*)(file.data() + header().levelsOffset))[i];
+    }
+    const uint8_t* levelData(uint32_t i) const { return file.data() + level(i).offset; }
+
+private:
+    MappedFile file;
+};
+
+// "textures/wall.jpg" -> "textures/wall.rtex" if that has been cooked, else
+// the source path unchanged
+std::string cookedTexturePath(const std::string& source);
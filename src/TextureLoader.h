@@ -0,0 +1,502 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "stb_image.h"   // implementation compiled in stb_image_imp.cpp
+
+#include "CpuProfiler.h"
+#include "GLExt.h"
+#include "GLState.h"
+#include "RenderStats.h"
+#include "TextureFile.h"
+
+// Textures loaded in the background. request() returns a handle at once;
+// worker threads prepare the file and update(), called once a frame on the
+// GL thread, streams it into the texture through a small ring of
+// pixel-unpack buffers, at most `budget` bytes a frame (big levels go up in
+// row bands over several frames). Until the last band is in, texture(handle)
+// is a 1x1 grey placeholder, so callers just bind texture(handle) every
+// frame. A PBO is refilled only once the fence of its last upload has
+// passed, so update() never waits on the GPU.
+//
+// Source images (.jpg, .png, ...) are decoded with stb_image (RGBA8,
+// flipped for GL, halved until they fit maxSize) and get their mipmaps from
+// glGenerateMipmap. Cooked .rtex files (tools/texture_cook) are only
+// memory-mapped: their BC1 / BC3 mip levels go to the GPU as they are, with
+// the levels above maxSize skipped (decoded to RGBA8 on the worker if the
+// driver has no S3TC).
+//
+// requestLayer() streams an image into one layer of a 2D array texture the
+// caller owns instead (TextureArray): the worker resamples it to the
+// layer's size, update() uploads it like any other level and regenerates
+// the array's mipmaps once it is in.
+//
+// threads = 0 prepares inside update() instead: with an unlimited budget
+// that is the load-it-all-now baseline (texture_bench). finish() waits for
+// everything requested so far, for callers that need it all at once.
+class TextureLoader {
+public:
+    using Handle = int;   // index of the texture, in request order
+
+    static const GLuint kUploadUnit = 15;   // texture unit used while uploading
+    static const int kPbos = 3;
+
+    explicit TextureLoader(int threads = 2, size_t budgetBytes = 4u << 20, int maxSize = 2048)
+        : budget(budgetBytes), maxSize(maxSize) {
+        const uint8_t grey[4] = { 128, 128, 128, 255 };
+        glGenTextures(1, &placeholder);
+        glState().bindTexture(kUploadUnit, GL_TEXTURE_2D, placeholder);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, grey);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        for (Pbo& p : pbos) glGenBuffers(1, &p.buffer);
+        for (int t = 0; t < threads; ++t) workers.emplace_back([this] { loop(); });
+    }
+
+    ~TextureLoader() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wake.notify_all();
+        for (std::thread& w : workers) w.join();
+
+        for (Pbo& p : pbos) {
+            if (p.fence) glDeleteSync(p.fence);
+            glState().deleteBuffers(1, &p.buffer);
+        }
+        for (Entry& e : entries)
+            if (e.texture && e.layer < 0) glState().deleteTextures(1, &e.texture);
+        glState().deleteTextures(1, &placeholder);
+    }
+
+    TextureLoader(const TextureLoader&) = delete;
+    TextureLoader& operator=(const TextureLoader&) = delete;
+
+    // the same path twice gives the same handle
+    Handle request(const std::string& path) {
+        auto it = byPath.find(path);
+        if (it != byPath.end()) return it->second;
+        Handle h = (Handle)entries.size();
+        entries.push_back(Entry{});
+        entries.back().path = path;
+        byPath.emplace(path, h);
+        queue(Job{ h, path, 0 });
+        return h;
+    }
+
+    // `path` resampled to size x size RGBA8 into `layer` of `array`, whose
+    // storage must already be there; every call loads again (the array may
+    // have been reallocated). The array stays the caller's: it is not
+    // deleted here nor counted in residentBytes().
+    Handle requestLayer(const std::string& path, GLuint array, int layer, int size) {
+        Handle h = (Handle)entries.size();
+        entries.push_back(Entry{});
+        entries.back().path = path;
+        entries.back().texture = array;
+        entries.back().layer = layer;
+        queue(Job{ h, path, size });
+        return h;
+    }
+
+    // the loaded texture once it is complete, the placeholder until then
+    // (and for good if the file could not be loaded)
+    GLuint texture(Handle h) const {
+        if (h < 0 || h >= (Handle)entries.size() || entries[h].state != State::Ready) return placeholder;
+        return entries[h].texture;
+    }
+
+    bool ready(Handle h) const { return h >= 0 && h < (Handle)entries.size() && entries[h].state == State::Ready; }
+    int pending() const { return waiting; }   // requested, not ready or failed yet
+    size_t count() const { return entries.size(); }
+
+    // video memory of the ready textures, all mip levels
+    size_t residentBytes() const {
+        size_t bytes = 0;
+        for (const Entry& e : entries)
+            if (e.state == State::Ready) bytes += e.gpuBytes;
+        return bytes;
+    }
+
+    // GL thread, once a frame: take the prepared textures, upload up to the budget
+    void update() {
+        PROFILE_SCOPE("TextureLoader::update");
+        if (workers.empty()) prepareQueued();
+        collectPrepared();
+        upload();
+    }
+
+    // GL thread: wait for the workers and upload everything requested so
+    // far, ignoring the budget (headless frames, benchmarks)
+    void finish() {
+        PROFILE_SCOPE("TextureLoader::finish");
+        const size_t frameBudget = budget;
+        budget = std::numeric_limits<size_t>::max();
+        while (waiting > 0) {
+            if (uploads.empty() && !workers.empty()) {
+                // nothing to upload, so something is still being prepared
+                std::unique_lock<std::mutex> lock(mutex);
+                arrived.wait(lock, [this] { return !prepared.empty(); });
+            }
+            update();
+            glFinish();   // lets upload() reuse every PBO on the next pass
+        }
+        budget = frameBudget;
+    }
+
+private:
+    enum class State { Loading, Uploading, Ready, Failed };
+
+    // one mip level as it goes to GL, in rows of texels or of 4x4 blocks
+    struct Level {
+        const uint8_t* data;   // into Source::pixels or the mapped file
+        int width, height;
+        int rows;
+        size_t rowBytes;
+    };
+
+    // what a worker hands over: the levels, and whatever owns their bytes
+    // (moving the vector keeps Level::data valid)
+    struct Source {
+        GLenum format = GL_RGBA8;   // internal format; anything else is compressed
+        bool buildMips = false;     // glGenerateMipmap after level 0
+        std::vector<Level> levels;
+        std::vector<uint8_t> pixels;
+        std::unique_ptr<MappedTexture> mapped;
+    };
+
+    struct Entry {
+        std::string path;
+        State state = State::Loading;
+        GLuint texture = 0;
+        int layer = -1;   // >= 0: a layer of the caller's array `texture`
+        Source src;   // freed once uploaded
+        int level = 0, rowsDone = 0;
+        size_t gpuBytes = 0;
+    };
+
+    struct Job {
+        Handle handle;
+        std::string path;
+        int layerSize;   // 0: a texture of its own
+    };
+
+    struct Prepared {
+        Handle handle;
+        bool ok = false;
+        Source src;
+    };
+
+    struct Pbo {
+        GLuint buffer = 0;
+        size_t capacity = 0;
+        GLsync fence = nullptr;   // last upload out of it
+    };
+
+    // GL thread only
+    std::vector<Entry> entries;
+    std::unordered_map<std::string, Handle> byPath;
+    std::deque<Handle> uploads;   // prepared, waiting for (more) upload
+    Pbo pbos[kPbos];
+    int nextPbo = 0;
+    GLuint placeholder = 0;
+    int waiting = 0;
+    size_t budget;
+    int maxSize;
+
+    // shared with the workers
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable arrived;   // something was added to prepared
+    std::deque<Job> jobs;
+    std::vector<Prepared> prepared;
+    bool quit = false;
+
+    void queue(Job job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+        wake.notify_one();
+        ++waiting;
+    }
+
+    void loop() {
+        PROFILE_THREAD("texture load");
+        for (;;) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return quit || !jobs.empty(); });
+                if (quit) return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            Prepared p = prepare(job);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                prepared.push_back(std::move(p));
+            }
+            arrived.notify_one();
+        }
+    }
+
+    void prepareQueued() {
+        std::deque<Job> todo;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            todo.swap(jobs);
+        }
+        for (const Job& job : todo) {
+            Prepared p = prepare(job);
+            std::lock_guard<std::mutex> lock(mutex);
+            prepared.push_back(std::move(p));
+        }
+    }
+
+    Prepared prepare(const Job& job) const {
+        PROFILE_SCOPE("prepare texture");
+        Prepared p;
+        p.handle = job.handle;
+        const std::string& path = job.path;
+        const bool cooked = path.size() > 5 && path.compare(path.size() - 5, 5, ".rtex") == 0;
+        if (job.layerSize > 0) p.ok = prepareLayer(path, cooked, job.layerSize, p.src);
+        else p.ok = cooked ? prepareCooked(path, p.src) : prepareImage(path, p.src);
+        return p;
+    }
+
+    // RGBA8, bottom row first
+    static bool decodeImage(const std::string& path, std::vector<uint8_t>& pixels, int& w, int& h) {
+        int channels = 0;
+        stbi_uc* data = stbi_load(path.c_str(), &w, &h, &channels, 4);
+        if (!data) {
+            std::cerr << "Texture load failed: " << path << " (" << stbi_failure_reason() << ")\n";
+            return false;
+        }
+        // GL's first row is the bottom one
+        const size_t rowBytes = (size_t)w * 4;
+        pixels.resize(rowBytes * h);
+        for (int y = 0; y < h; ++y)
+            std::memcpy(&pixels[(size_t)(h - 1 - y) * rowBytes], data + (size_t)y * rowBytes, rowBytes);
+        stbi_image_free(data);
+        return true;
+    }
+
+    bool prepareImage(const std::string& path, Source& src) const {
+        int w = 0, h = 0;
+        if (!decodeImage(path, src.pixels, w, h)) return false;
+        while (maxSize > 0 && std::max(w, h) > maxSize) halveImage(src.pixels, w, h);
+        src.buildMips = true;
+        src.levels.push_back(Level{ src.pixels.data(), w, h, h, (size_t)w * 4 });
+        return true;
+    }
+
+    bool prepareCooked(const std::string& path, Source& src) const {
+        src.mapped.reset(new MappedTexture());
+        std::string err;
+        if (!src.mapped->open(path, err)) {
+            std::cerr << "Texture load failed: " << err << "\n";
+            return false;
+        }
+        const MappedTexture& m = *src.mapped;
+        const TextureFormat format = m.header().format;
+        const bool decode = format != TextureFormat::RGBA8 && !GLExt::s3tc;
+        src.format = format == TextureFormat::BC1 && !decode ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+            : format == TextureFormat::BC3 && !decode ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+            : GL_RGBA8;
+
+        uint32_t first = 0;
+        while (maxSize > 0 && first + 1 < m.header().levelCount &&
+               std::max(m.level(first).width, m.level(first).height) > (uint32_t)maxSize)
+            ++first;
+
+        std::vector<size_t> offsets;   // into pixels when decoding
+        for (uint32_t i = first; i < m.header().levelCount; ++i) {
+            const TextureLevelDesc& d = m.level(i);
+            const int w = (int)d.width, h = (int)d.height;
+            if (decode) {
+                std::vector<uint8_t> rgba;
+                decodeTextureLevel(format, m.levelData(i), w, h, rgba);
+                offsets.push_back(src.pixels.size());
+                src.pixels.insert(src.pixels.end(), rgba.begin(), rgba.end());
+                src.levels.push_back(Level{ nullptr, w, h, h, (size_t)w * 4 });
+            } else if (format == TextureFormat::RGBA8) {
+                src.levels.push_back(Level{ m.levelData(i), w, h, h, (size_t)w * 4 });
+            } else {
+                const int blockRows = std::max(1, (h + 3) / 4);
+                src.levels.push_back(Level{ m.levelData(i), w, h, blockRows, (size_t)d.size / blockRows });
+            }
+        }
+        if (decode) {
+            for (size_t i = 0; i < src.levels.size(); ++i) src.levels[i].data = src.pixels.data() + offsets[i];
+            src.mapped.reset();
+            return true;
+        }
+
+        // fault the pages in here rather than in the GL thread's memcpy
+        volatile uint8_t sink = 0;
+        for (const Level& l : src.levels)
+            for (size_t at = 0; at < l.rowBytes * l.rows; at += 4096) sink = sink + l.data[at];
+        return true;
+    }
+
+    // one size x size level from the smallest cooked level that still
+    // covers it (decoded from BC on the CPU), or from the decoded source
+    static bool prepareLayer(const std::string& path, bool cooked, int size, Source& src) {
+        std::vector<uint8_t> pixels;
+        int w = 0, h = 0;
+        if (cooked) {
+            MappedTexture m;
+            std::string err;
+            if (!m.open(path, err)) {
+                std::cerr << "Texture load failed: " << err << "\n";
+                return false;
+            }
+            uint32_t pick = 0;
+            while (pick + 1 < m.header().levelCount &&
+                   (int)m.level(pick + 1).width >= size && (int)m.level(pick + 1).height >= size)
+                ++pick;
+            w = (int)m.level(pick).width;
+            h = (int)m.level(pick).height;
+            if (m.header().format == TextureFormat::RGBA8)
+                pixels.assign(m.levelData(pick), m.levelData(pick) + m.level(pick).size);
+            else
+                decodeTextureLevel(m.header().format, m.levelData(pick), w, h, pixels);
+        }
+        else if (!decodeImage(path, pixels, w, h)) return false;
+
+        while (w >= 2 * size && h >= 2 * size) halveImage(pixels, w, h);
+        resampleImage(pixels, w, h, size, src.pixels);
+        src.buildMips = true;
+        src.levels.push_back(Level{ src.pixels.data(), size, size, size, (size_t)size * 4 });
+        return true;
+    }
+
+    void collectPrepared() {
+        std::vector<Prepared> done;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done.swap(prepared);
+        }
+        for (Prepared& p : done) {
+            Entry& e = entries[p.handle];
+            if (!p.ok) {
+                e.state = State::Failed;
+                --waiting;
+                continue;
+            }
+            e.src = std::move(p.src);
+            e.state = State::Uploading;
+            uploads.push_back(p.handle);
+        }
+    }
+
+    // storage for every level, while no unpack buffer is bound (a null
+    // pointer would be an offset into it)
+    void allocate(Entry& e) {
+        const Source& src = e.src;
+        glGenTextures(1, &e.texture);
+        glState().bindTexture(kUploadUnit, GL_TEXTURE_2D, e.texture);
+        for (size_t i = 0; i < src.levels.size(); ++i) {
+            const Level& l = src.levels[i];
+            if (src.format == GL_RGBA8)
+                glTexImage2D(GL_TEXTURE_2D, (GLint)i, GL_RGBA8, l.width, l.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            else
+                glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)i, src.format, l.width, l.height, 0,
+                    (GLsizei)(l.rowBytes * l.rows), nullptr);
+            e.gpuBytes += l.rowBytes * l.rows;
+        }
+        if (src.buildMips) e.gpuBytes += e.gpuBytes / 3;
+        else glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)src.levels.size() - 1);
+        const bool mips = src.buildMips || src.levels.size() > 1;
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mips ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    }
+
+    void upload() {
+        GLState& gl = glState();
+        size_t used = 0;
+        while (!uploads.empty()) {
+            Entry& e = entries[uploads.front()];
+            const Level& l = e.src.levels[e.level];
+            const size_t left = budget - used;
+            if (used > 0 && left < l.rowBytes) break;
+            const int rows = (int)std::min<size_t>(l.rows - e.rowsDone, std::max<size_t>(1, left / l.rowBytes));
+            const size_t bytes = l.rowBytes * rows;
+
+            Pbo& pbo = pbos[nextPbo];
+            if (pbo.fence) {
+                GLenum status = glClientWaitSync(pbo.fence, 0, 0);
+                if (status == GL_TIMEOUT_EXPIRED) break;   // GPU still reading it; next frame
+                glDeleteSync(pbo.fence);
+                pbo.fence = nullptr;
+            }
+
+            if (!e.texture) {
+                gl.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                allocate(e);
+            }
+
+            gl.bindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo.buffer);
+            if (pbo.capacity < bytes) {
+                glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+                pbo.capacity = bytes;
+            }
+            // the fence says the GPU is done with the old contents
+            void* dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes,
+                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+            if (!dst) break;
+            std::memcpy(dst, l.data + l.rowBytes * e.rowsDone, bytes);
+            if (!glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER)) break;   // contents lost; redo next frame
+
+            const GLenum target = e.layer >= 0 ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+            gl.bindTexture(kUploadUnit, target, e.texture);
+            if (e.layer >= 0) {
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, e.rowsDone, e.layer, l.width, rows, 1,
+                    GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            } else if (e.src.format == GL_RGBA8) {
+                glTexSubImage2D(GL_TEXTURE_2D, e.level, 0, e.rowsDone, l.width, rows, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            } else {
+                // block rows; the last one may hang over the level's edge
+                const int y = e.rowsDone * 4;
+                glCompressedTexSubImage2D(GL_TEXTURE_2D, e.level, 0, y, l.width, std::min(rows * 4, l.height - y),
+                    e.src.format, (GLsizei)bytes, nullptr);
+            }
+            pbo.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            nextPbo = (nextPbo + 1) % kPbos;
+            renderStats().textureBytes += bytes;
+            used += bytes;
+
+            e.rowsDone += rows;
+            if (e.rowsDone < l.rows) continue;
+            e.rowsDone = 0;
+            if (++e.level < (int)e.src.levels.size()) continue;
+            if (e.src.buildMips) glGenerateMipmap(target);
+            e.src = Source();
+            e.state = State::Ready;
+            --waiting;
+            uploads.pop_front();
+        }
+        // plain glTexImage2D calls elsewhere pass client pointers
+        gl.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+
+// Normal matrix (inverse-transpose of the upper 3x3) for a model matrix,
+// computed once per object on the CPU instead of per vertex in the shader.
+// Every box in the scene is translate * rotate * scale, so its axes are
+// orthogonal and the inverse can be skipped:
+//   A = R * S  ->  inverse(A)^T = R * S^-1 = columns of A divided by |a_i|^2
+// With a uniform scale the result is just A (shaders renormalize Normal).
+inline glm::mat3 normalMatrix(const glm::mat4& M) {
+    glm::mat3 A(M);
+
+    float s0 = glm::dot(A[0], A[0]);
+    float s1 = glm::dot(A[1], A[1]);
+    float s2 = glm::dot(A[2], A[2]);
+    float eps = 1e-5f * std::fmax(s0, std::fmax(s1, s2));
+
+    bool orthogonal = std::fabs(glm::dot(A[0], A[1])) <= eps &&
+                      std::fabs(glm::dot(A[0], A[2])) <= eps &&
+                      std::fabs(glm::dot(A[1], A[2])) <= eps;
+
+    if (orthogonal && s0 > 0.0f && s1 > 0.0f && s2 > 0.0f) {
+        if (std::fabs(s0 - s1) <= eps && std::fabs(s0 - s2) <= eps)
+            return A; // rotation + uniform scale
+        return glm::mat3(A[0] / s0, A[1] / s1, A[2] / s2);
+    }
+
+    // general case (shear etc.)
+    return glm::transpose(glm::inverse(A));
+}
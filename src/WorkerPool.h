@@ -0,0 +1,97 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "CpuProfiler.h"
+
+// Persistent worker threads for data-parallel loops inside a frame:
+// forEach(n, fn) calls fn(i) for every i in [0, n) across the workers and
+// the calling thread, and returns when all calls are done. Indices are
+// handed out one at a time, so uneven work balances itself. Not reentrant.
+class WorkerPool {
+public:
+    // workers besides the caller; -1: one per hardware thread, minus the caller
+    explicit WorkerPool(int threads = -1) {
+        if (threads < 0) threads = (int)std::max(1u, std::thread::hardware_concurrency()) - 1;
+        for (int t = 0; t < threads; ++t) workers.emplace_back([this] { loop(); });
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wake.notify_all();
+        for (std::thread& w : workers) w.join();
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    unsigned threadCount() const { return (unsigned)workers.size() + 1; }
+
+    void forEach(int n, const std::function<void(int)>& fn) {
+        if (n <= 0) return;
+        if (workers.empty() || n == 1) {
+            for (int i = 0; i < n; ++i) fn(i);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &fn;
+            count = n;
+            next = 0;
+            busy = (int)workers.size();
+            ++generation;
+        }
+        wake.notify_all();
+        run(fn, n);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return busy == 0; });
+        job = nullptr;
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    const std::function<void(int)>* job = nullptr;
+    int count = 0;
+    std::atomic<int> next{ 0 };
+    int busy = 0;
+    unsigned generation = 0;
+    bool quit = false;
+
+    void run(const std::function<void(int)>& fn, int n) {
+        for (int i = next++; i < n; i = next++) fn(i);
+    }
+
+    void loop() {
+        PROFILE_THREAD("worker");
+        unsigned seen = 0;
+        for (;;) {
+            const std::function<void(int)>* fn;
+            int n;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return quit || generation != seen; });
+                if (quit) return;
+                seen = generation;
+                fn = job;
+                n = count;
+            }
+            run(*fn, n);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--busy == 0) done.notify_one();
+            }
+        }
+    }
+};
@@ -0,0 +1,31 @@
+#version 330 core
+// deferred path, lighting pass (with deferred.vert): one full-screen pass
+// that reads the G-buffer and shades every pixel once with the lights of its
+// cluster, so overdraw in the geometry pass costs no lighting. The shading
+// itself is lighting.glsl, the same as room.frag's.
+out vec4 FragColor;
+
+#include "frame_uniforms.glsl"
+
+// G-buffer (GBuffer.h) on units 0..2
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+uniform mat4 invViewProj;
+
+#include "lighting.glsl"
+
+void main()
+{
+    ivec2 px = ivec2(gl_FragCoord.xy);
+    float d = texelFetch(gDepth, px, 0).r;
+    if (d == 1.0) discard;  // nothing drawn: keep the clear color
+
+    vec3 albedo = texelFetch(gAlbedo, px, 0).rgb;
+    vec3 N = normalize(texelFetch(gNormal, px, 0).xyz * 2.0 - 1.0);
+    vec2 ndc = gl_FragCoord.xy / vec2(textureSize(gDepth, 0)) * 2.0 - 1.0;
+    vec4 world = invViewProj * vec4(ndc, d * 2.0 - 1.0, 1.0);
+    vec3 FragPos = world.xyz / world.w;
+
+    FragColor = vec4(shade(albedo, FragPos, N), 1.0);
+}
@@ -0,0 +1,4 @@
+#version 330 core
+// depth pre-pass: color writes are masked off, depth is all that's wanted
+void main() {
+}
@@ -0,0 +1,15 @@
+#version 330 core
+// depth pre-pass: same instance streams as room.vert, position only
+layout(location=0) in vec3 aPos;
+layout(location=2) in mat4 model;   // per-instance (BoxBatch), locations 2..5
+
+#include "frame_uniforms.glsl"
+
+// the lit pass tests GL_EQUAL against this depth, so both programs must
+// compute gl_Position the exact same way (room.vert is invariant too)
+invariant gl_Position;
+
+void main() {
+    vec4 worldPos = model * vec4(aPos, 1.0);
+    gl_Position = projection * view * worldPos;
+}
@@ -0,0 +1,16 @@
+// per-frame state shared by every program (FrameUniforms.h, binding 0);
+// Shader::load pastes this in wherever a shader says
+//   #include "frame_uniforms.glsl"
+layout(std140) uniform FrameUniforms {
+    mat4  view;
+    mat4  projection;
+    vec3  viewPos;      float ambientScale;     // night mode dims ambient
+    vec3  lightPos0;    float flashCutoff;      // cos(innerAngle)
+    vec3  lightColor0;  float flashOuterCutoff; // cos(outerAngle)
+    vec3  lightPos1;    float fogDensity;       // e.g., 0.03
+    vec3  lightColor1;  int   useFlashlight;    // 0/1
+    vec3  flashDir;     int   useFog;           // 0/1
+    vec3  flashColor;   float framePad0;
+    vec3  fogColor;     float framePad1;
+    vec4  clusterScale;   // clustered lights: xy tiles per pixel, slice = log(depth) * z + w
+};
@@ -0,0 +1,19 @@
+#version 330 core
+// deferred path, geometry pass (with room.vert): surface attributes only,
+// lighting happens once per pixel in deferred.frag
+in vec3 FragPos;
+in vec3 Normal;
+in vec3 objectColor;
+in vec2 vUV;
+flat in float vLayer;
+
+uniform sampler2DArray materials;   // as in room.frag
+
+layout(location = 0) out vec4 gAlbedo;
+layout(location = 1) out vec4 gNormal;   // RGB10_A2, n * 0.5 + 0.5
+
+void main() {
+    vec3 tex = texture(materials, vec3(vUV, max(vLayer, 0.0))).rgb;
+    gAlbedo = vec4(vLayer >= 0.0 ? objectColor * tex : objectColor, 1.0);
+    gNormal = vec4(normalize(Normal) * 0.5 + 0.5, 1.0);
+}
@@ -0,0 +1,96 @@
+// Shading shared by the forward (room.frag) and deferred (deferred.frag)
+// paths; both #include it after frame_uniforms.glsl, so one edit changes
+// both and their images stay identical.
+
+// clustered point lights (LightClusters.h); samplers on units 4..6
+const int kTilesX = 16;
+const int kTilesY = 9;
+const int kSlices = 24;
+uniform usamplerBuffer clusterGrid;    // per cluster: first index, light count
+uniform usamplerBuffer clusterLights;  // light indices, grouped by cluster
+uniform samplerBuffer  lightData;      // per light: position + radius, color
+
+// --------------------------------------
+vec3 phongPointLight(vec3 lp, float radius, vec3 lc, vec3 albedo, vec3 fragPos, vec3 N, vec3 V)
+{
+    vec3 L = normalize(lp - fragPos);
+    float dist = length(lp - fragPos);
+    float att = 1.0 / (1.0 + 0.22*dist + 0.20*dist*dist); // moderate falloff
+
+    // fade to zero at the radius, past which the clusters drop the light
+    float x = dist / radius;
+    float window = clamp(1.0 - x*x*x*x, 0.0, 1.0);
+    att *= window * window;
+
+    float diff = max(dot(N, L), 0.0);
+
+    vec3 R   = reflect(-L, N);
+    float spec = pow(max(dot(V, R), 0.0), 32.0);
+
+    float specularStrength = 0.5;
+    vec3 diffuse  = diff * lc;
+    vec3 specular = specularStrength * spec * lc;
+
+    return att * (diffuse + specular) * albedo;
+}
+
+vec3 flashlight(vec3 albedo, vec3 fragPos, vec3 N, vec3 V)
+{
+    // flashlight originates at camera (viewPos), points along flashDir
+    vec3 Ldir   = normalize(fragPos - viewPos);
+    float theta = dot(normalize(-Ldir), normalize(flashDir)); // how aligned with cone
+
+    float epsilon = flashCutoff - flashOuterCutoff;
+    float intensity = clamp((theta - flashOuterCutoff) / epsilon, 0.0, 1.0);
+
+    if (intensity <= 0.0) return vec3(0.0);
+
+    // Phong within the spotlight cone
+    vec3 L = normalize(viewPos - fragPos);
+    float diff = max(dot(N, L), 0.0);
+    vec3 R = reflect(-L, N);
+    float spec = pow(max(dot(V, R), 0.0), 32.0);
+
+    float specularStrength = 0.6;
+    vec3 ambient  = ambientScale * flashColor * 0.2;
+    vec3 diffuse  = diff * flashColor;
+    vec3 specular = specularStrength * spec * flashColor;
+
+    // no distance attenuation here (flashlight is close & cone-limited)
+    return (ambient + intensity * (diffuse + specular)) * albedo;
+}
+
+// final color of a surface point: ambient, its cluster's lights, the
+// flashlight and fog. N is normalized
+vec3 shade(vec3 albedo, vec3 fragPos, vec3 N)
+{
+    vec3 V = normalize(viewPos - fragPos);
+
+    // ambient as the two fixed lights used to give it, whatever the light count
+    vec3 total = ambientScale * (lightColor0 + lightColor1) * albedo;
+
+    // only the lights binned into this fragment's cluster
+    float depth = -(view * vec4(fragPos, 1.0)).z;
+    ivec2 tile = clamp(ivec2(gl_FragCoord.xy * clusterScale.xy), ivec2(0), ivec2(kTilesX - 1, kTilesY - 1));
+    int slice = clamp(int(log(depth) * clusterScale.z + clusterScale.w), 0, kSlices - 1);
+    uvec2 cluster = texelFetch(clusterGrid, (slice * kTilesY + tile.y) * kTilesX + tile.x).xy;
+    for (uint i = 0u; i < cluster.y; ++i) {
+        int l = int(texelFetch(clusterLights, int(cluster.x + i)).r);
+        vec4 posRadius = texelFetch(lightData, 2 * l);
+        vec3 color = texelFetch(lightData, 2 * l + 1).rgb;
+        total += phongPointLight(posRadius.xyz, posRadius.w, color, albedo, fragPos, N, V);
+    }
+
+    if (useFlashlight == 1) {
+        total += flashlight(albedo, fragPos, N, V);
+    }
+
+    // fog (exp2)
+    if (useFog == 1) {
+        float dist = length(viewPos - fragPos);
+        float f = 1.0 - exp(-pow(fogDensity * dist, 2.0));
+        total = mix(total, fogColor, clamp(f, 0.0, 1.0));
+    }
+
+    return total;
+}
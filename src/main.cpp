@@ -6,10 +6,26 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <iostream>
+#include <string>
 #include "shader.h"
 #include "Furniture.h"   // your drawCoffeeTable / drawTVStand / drawSofa using objectColor
+#include "SceneFile.h"
+#include "RoomRenderer.h"
+#include "Headless.h"
+#include "CpuProfiler.h"
+#include "GLExt.h"
+#include "GLState.h"
+#include "GpuProfiler.h"
+#include "Paths.h"
+#include "RenderStats.h"
+#include "ShaderCompiler.h"
+#include "ShaderWatcher.h"
 
 #include <algorithm> 
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
 
 // ------------ window ------------
 const unsigned int SCR_WIDTH = 1280;
@@ -30,9 +46,10 @@ float mouseSens = 0.08f;  // degrees/pixel
 bool flashlightOn = true;
 bool fogOn = false;
 bool nightMode = false;   // dims ambient
+bool showProfiler = false; // GPU pass bars + times in the title
 
 // for input debounce
-bool lastF = false, lastG = false, lastN = false;
+bool lastF = false, lastG = false, lastN = false, lastP = false, lastI = false, lastO = false, lastR = false, lastZ = false;
 
 
 // ------------ callbacks ------------
@@ -59,7 +76,8 @@ void mouse_callback(GLFWwindow*, double xpos, double ypos) {
     camFront = glm::normalize(f);
 }
 
-void processInput(GLFWwindow* window, float dt) {
+void processInput(GLFWwindow* window, float dt, const std::vector<RoomDesc>& rooms) {
+    PROFILE_SCOPE("processInput");
     float v = moveSpeed * dt;
     glm::vec3 right = glm::normalize(glm::cross(camFront, camUp));
     if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) camPos += v * camFront;
@@ -71,81 +89,68 @@ void processInput(GLFWwindow* window, float dt) {
 
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) glfwSetWindowShouldClose(window, true);
 
-    // clamp position to room bounds
-        // --- keep camera inside the room box ---
-    const float minX = -4.5f;
-    const float maxX =  4.5f;
-    const float minZ = -6.5f;
-    const float maxZ =  6.5f;
-    const float minY =  0.2f;  // a bit above floor
-    const float maxY =  3.5f;  // a bit below ceiling
-
-    camPos.x = std::clamp(camPos.x, minX, maxX);
-    camPos.z = std::clamp(camPos.z, minZ, maxZ);
+    // keep the camera inside the rooms: their union, half a metre off the
+    // outer walls (the rooms of a scene tile a rectangle, doorways between)
+    if (rooms.empty()) return;
+    glm::vec2 lo(rooms[0].center.x, rooms[0].center.z), hi = lo;
+    for (const RoomDesc& r : rooms) {
+        const glm::vec2 c(r.center.x, r.center.z), h(r.size.x * 0.5f, r.size.z * 0.5f);
+        lo = glm::min(lo, c - h);
+        hi = glm::max(hi, c + h);
+    }
+    const float margin = 0.5f;
+    camPos.x = std::clamp(camPos.x, lo.x + margin, hi.x - margin);
+    camPos.z = std::clamp(camPos.z, lo.y + margin, hi.y - margin);
 }
 
-// 0xRRGGBB -> glm::vec3
-glm::vec3 hexColor(unsigned int hex) {
-    float r = ((hex >> 16) & 0xFF) / 255.0f;
-    float g = ((hex >> 8) & 0xFF) / 255.0f;
-    float b = ((hex) & 0xFF) / 255.0f;
-    return glm::vec3(r, g, b);
-}
+// usage: FinalRoom [--profile out.csv|out.json] [--trace trace.json] [scene.scene | scene.rscn]
+//        FinalRoom --convert in.scene out.rscn
+//        FinalRoom --headless FRAMES OUT_DIR [--path cam.path] [--size WxH] [scene]
+int main(int argc, char** argv) {
+    std::string scenePath = assetPath("scenes/living_room.scene");
+    if (argc >= 4 && std::string(argv[1]) == "--convert") {
+        SceneDesc desc;
+        std::string err;
+        if (!loadSceneText(argv[2], desc, err)) { std::cerr << err << "\n"; return 1; }
+        if (!saveSceneBinary(argv[3], desc)) { std::cerr << "cannot write " << argv[3] << "\n"; return 1; }
+        return 0;
+    }
+    // linked programs are kept between runs (src/ShaderCache.h)
+    shaderCache().open(assetPath(".shadercache"));
+    if (argc >= 4 && std::string(argv[1]) == "--headless") {
+        HeadlessOptions opt;
+        opt.frames = std::atoi(argv[2]);
+        opt.outDir = argv[3];
+        opt.scenePath = scenePath;
+        for (int i = 4; i < argc; ++i) {
+            std::string a = argv[i];
+            if (a == "--path" && i + 1 < argc) opt.cameraPath = argv[++i];
+            else if (a == "--size" && i + 1 < argc) std::sscanf(argv[++i], "%dx%d", &opt.width, &opt.height);
+            else opt.scenePath = a;
+        }
+        return runHeadless(opt);
+    }
+    std::string profileOut, traceOut;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--profile" && i + 1 < argc) profileOut = argv[++i];
+        else if (a == "--trace" && i + 1 < argc) traceOut = argv[++i];
+        else scenePath = a;
+    }
+
+    if (!traceOut.empty() && !FINALROOM_CPU_PROFILER)
+        std::cerr << "--trace: built without FINALROOM_CPU_PROFILER, trace will be empty\n";
+    PROFILE_THREAD("main");
 
-// Simple cube (pos+normal, 36 verts). Keep the same you had before.
-static float cubeVertices[] = {
-    // back (-Z)
-    -0.5f,-0.5f,-0.5f,  0,0,-1,
-     0.5f,-0.5f,-0.5f,  0,0,-1,
-     0.5f, 0.5f,-0.5f,  0,0,-1,
-     0.5f, 0.5f,-0.5f,  0,0,-1,
-    -0.5f, 0.5f,-0.5f,  0,0,-1,
-    -0.5f,-0.5f,-0.5f,  0,0,-1,
-    // front (+Z)
-    -0.5f,-0.5f, 0.5f,  0,0,1,
-     0.5f,-0.5f, 0.5f,  0,0,1,
-     0.5f, 0.5f, 0.5f,  0,0,1,
-     0.5f, 0.5f, 0.5f,  0,0,1,
-    -0.5f, 0.5f, 0.5f,  0,0,1,
-    -0.5f,-0.5f, 0.5f,  0,0,1,
-    // left (-X)
-    -0.5f, 0.5f, 0.5f, -1,0,0,
-    -0.5f, 0.5f,-0.5f, -1,0,0,
-    -0.5f,-0.5f,-0.5f, -1,0,0,
-    -0.5f,-0.5f,-0.5f, -1,0,0,
-    -0.5f,-0.5f, 0.5f, -1,0,0,
-    -0.5f, 0.5f, 0.5f, -1,0,0,
-    // right (+X)
-     0.5f, 0.5f, 0.5f,  1,0,0,
-     0.5f, 0.5f,-0.5f,  1,0,0,
-     0.5f,-0.5f,-0.5f,  1,0,0,
-     0.5f,-0.5f,-0.5f,  1,0,0,
-     0.5f,-0.5f, 0.5f,  1,0,0,
-     0.5f, 0.5f, 0.5f,  1,0,0,
-     // bottom (-Y)
-     -0.5f,-0.5f,-0.5f,  0,-1,0,
-      0.5f,-0.5f,-0.5f,  0,-1,0,
-      0.5f,-0.5f, 0.5f,  0,-1,0,
-      0.5f,-0.5f, 0.5f,  0,-1,0,
-     -0.5f,-0.5f, 0.5f,  0,-1,0,
-     -0.5f,-0.5f,-0.5f,  0,-1,0,
-     // top (+Y)
-     -0.5f, 0.5f,-0.5f,  0,1,0,
-      0.5f, 0.5f,-0.5f,  0,1,0,
-      0.5f, 0.5f, 0.5f,  0,1,0,
-      0.5f, 0.5f, 0.5f,  0,1,0,
-     -0.5f, 0.5f, 0.5f,  0,1,0,
-     -0.5f, 0.5f,-0.5f,  0,1,0,
-};
-
-int main() {
     // --- init window ---
     glfwInit();
+    // terminate last, after the GL objects below (RoomRenderer) are destroyed
+    struct GlfwGuard { ~GlfwGuard() { glfwTerminate(); } } glfwGuard;
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Phase 5 - Light & Camera", nullptr, nullptr);
-    if (!window) { std::cerr << "GLFW create window failed\n"; glfwTerminate(); return -1; }
+    if (!window) { std::cerr << "GLFW create window failed\n"; return -1; }
     glfwMakeContextCurrent(window);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
@@ -154,164 +159,116 @@ int main() {
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
         std::cerr << "GLAD init failed\n"; return -1;
     }
-    glEnable(GL_DEPTH_TEST);
-    glDisable(GL_CULL_FACE);
-
-    // --- shader ---
-    Shader solidShader("C:/Users/User/OneDrive/Documents/computer graphics/CS4361_Final_Project_3D_LivingRoom-main/src/room.vert",
-        "C:/Users/User/OneDrive/Documents/computer graphics/CS4361_Final_Project_3D_LivingRoom-main/src/room.frag"); // <- put your real paths
-
-    // --- cube VAO/VBO ---
-    unsigned int cubeVAO = 0, cubeVBO = 0;
-    glGenVertexArrays(1, &cubeVAO);
-    glGenBuffers(1, &cubeVBO);
-    glBindVertexArray(cubeVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices), cubeVertices, GL_STATIC_DRAW);
-    // pos
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    // normal
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glBindVertexArray(0);
-
-    // furniture context
-    FurnitureContext ctx{ cubeVAO, &solidShader };
-
-    // room blocks (positions + scales)
-    glm::vec3 floorPos = { 0.0f, 0.0f,  0.0f };  glm::vec3 floorScale = { 10.0f, 0.1f, 14.0f };
-    glm::vec3 ceilPos = { 0.0f, 4.0f,  0.0f };  glm::vec3 ceilScale = { 10.0f, 0.1f, 14.0f };
-    glm::vec3 backPos = { 0.0f, 2.0f, -7.0f };  glm::vec3 backScale = { 10.0f, 4.0f,  0.1f };
-    glm::vec3 frontPos = { 0.0f, 2.0f,  7.0f };  glm::vec3 frontScale = { 10.0f, 4.0f,  0.1f };
-    glm::vec3 leftPos = { -5.0f,2.0f,  0.0f };  glm::vec3 leftScale = { 0.1f,  4.0f, 14.0f };
-    glm::vec3 rightPos = { 5.0f,2.0f,  0.0f };  glm::vec3 rightScale = { 0.1f,  4.0f, 14.0f };
-
-    // colors
-    glm::vec3 floorCol = hexColor(0x6B8E23); // olive-ish
-    glm::vec3 ceilCol = hexColor(0xE0E0E0);
-    glm::vec3 backCol = hexColor(0xC0D6FF);
-    glm::vec3 frontCol = hexColor(0xC0D6FF);
-    glm::vec3 sideCol = hexColor(0xADD8E6);
-
-    // light
-    glm::vec3 lightPos(0.0f, 3.0f, 2.5f);
-    glm::vec3 lightColor(1.0f);
-
-
-    glm::vec3 lightPos0 = glm::vec3(0.0f, 3.0f, 2.5f);  // ceiling-ish
-    glm::vec3 lightCol0 = glm::vec3(1.0f);
-
-    glm::vec3 lightPos1 = glm::vec3(0.0f, 1.0f, -2.2f);  // near TV stand
-    glm::vec3 lightCol1 = glm::vec3(1.0f, 0.95f, 0.80f); // warm
+    GLExt::load((GLADloadproc)glfwGetProcAddress);
+    glState().enable(GL_DEPTH_TEST, true);
+    glState().enable(GL_CULL_FACE, false);
+
+    // reloaded shaders build on a second context when the driver cannot
+    // compile in the background itself; declared first, so it outlives the renderer
+    std::unique_ptr<ShaderCompiler> shaderCompiler;
+    if (!GLExt::parallelShaderCompile) shaderCompiler = std::make_unique<ShaderCompiler>(window);
+
+    // --- shader, cube VAO, baked scene, frame UBO ---
+    RoomRenderer renderer;
+    renderer.shaderCompiler = shaderCompiler.get();
+    std::string sceneErr;
+    if (!renderer.loadScene(scenePath, sceneErr)) {
+        std::cerr << "Scene load failed: " << sceneErr << "\n"; return -1;
+    }
+
+    // edit a shader in src/ and the running renderer picks it up
+    ShaderWatcher shaderWatcher(assetPath("src"));
+
+    // GPU pass timings (P: overlay, I: one pass per scene item)
+    GpuProfiler profiler;
+    profiler.recording = !profileOut.empty();
+    renderer.profiler = &profiler;
+    float lastTitle = 0.0f;
 
     // time for smooth movement
     float lastTime = (float)glfwGetTime();
 
     while (!glfwWindowShouldClose(window)) {
+        PROFILE_SCOPE("frame");
+        renderStats().reset();
         float now = (float)glfwGetTime();
         float dt = now - lastTime;
         lastTime = now;
-        processInput(window, dt);
+        processInput(window, dt, renderer.sceneDesc.rooms);
 
 
-        // --- toggles (F flashlight, G fog, N night) ---
+        // --- toggles (F flashlight, G fog, N night, P profiler, I per-item passes, O occlusion, R deferred, Z depth pre-pass) ---
         bool F = glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS;
         bool G = glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS;
         bool N = glfwGetKey(window, GLFW_KEY_N) == GLFW_PRESS;
+        bool P = glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS;
+        bool I = glfwGetKey(window, GLFW_KEY_I) == GLFW_PRESS;
+        bool O = glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS;
+        bool R = glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS;
+        bool Z = glfwGetKey(window, GLFW_KEY_Z) == GLFW_PRESS;
 
         if (F && !lastF) flashlightOn = !flashlightOn;
         if (G && !lastG) fogOn = !fogOn;
         if (N && !lastN) nightMode = !nightMode;
+        if (P && !lastP) {
+            showProfiler = !showProfiler;
+            if (!showProfiler) glfwSetWindowTitle(window, "Phase 5 - Light & Camera");
+        }
+        if (I && !lastI) profiler.splitPasses = !profiler.splitPasses;
+        if (O && !lastO) renderer.occlusionCulling = !renderer.occlusionCulling;
+        if (R && !lastR) renderer.deferred = !renderer.deferred;
+        if (Z && !lastZ) renderer.depthPrepass = !renderer.depthPrepass;
+
+        lastF = F; lastG = G; lastN = N; lastP = P; lastI = I; lastO = O; lastR = R; lastZ = Z;
+
+        ViewState view;
+        view.camPos = camPos;
+        view.camFront = camFront;
+        view.camUp = camUp;
+        view.flashlightOn = flashlightOn;
+        view.fogOn = fogOn;
+        view.nightMode = nightMode;
+
+        int fbW = 0, fbH = 0;
+        glfwGetFramebufferSize(window, &fbW, &fbH);
+        renderer.updateShaders(shaderWatcher.takeChanged());
+        profiler.beginFrame();
+        if (fbW > 0 && fbH > 0) renderer.renderFrame(view, fbW, fbH);
+        if (showProfiler) {
+            GpuProfiler::Scope pass(&profiler, "overlay");
+            profiler.drawOverlay(fbW, fbH);
+        }
+        renderer.endFrame();
 
-        lastF = F; lastG = G; lastN = N;
-
-
-
-        glClearColor(0.08f, 0.08f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // camera matrices
-        glm::mat4 view = glm::lookAt(camPos, camPos + camFront, camUp);
-        glm::mat4 proj = glm::perspective(glm::radians(45.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-
-       /* solidShader.use();
-        solidShader.setMat4("view", view);
-        solidShader.setMat4("projection", proj);
-        solidShader.setVec3("lightPos", lightPos);
-        solidShader.setVec3("lightColor", lightColor);
-        solidShader.setVec3("viewPos", camPos);*/
-
-        solidShader.use();
-        solidShader.setMat4("view", view);
-        solidShader.setMat4("projection", proj);
-        solidShader.setVec3("viewPos", camPos);
-
-        // point lights
-        solidShader.setVec3("lightPos0", lightPos0);
-        solidShader.setVec3("lightColor0", lightCol0);
-        solidShader.setVec3("lightPos1", lightPos1);
-        solidShader.setVec3("lightColor1", lightCol1);
-
-        // flashlight (camera-mounted)
-        solidShader.setInt("useFlashlight", flashlightOn ? 1 : 0);
-        solidShader.setVec3("flashDir", glm::normalize(camFront));
-        // inner/outer cone angles
-        float innerDeg = 15.0f;
-        float outerDeg = 22.0f;
-        solidShader.setFloat("flashCutoff", cos(glm::radians(innerDeg)));
-        solidShader.setFloat("flashOuterCutoff", cos(glm::radians(outerDeg)));
-        solidShader.setVec3("flashColor", glm::vec3(1.0f, 0.98f, 0.9f));
-
-        // ambient scaling (night mode)
-        solidShader.setFloat("ambientScale", nightMode ? 0.05f : 0.15f);
-
-        // fog
-        solidShader.setInt("useFog", fogOn ? 1 : 0);
-        solidShader.setVec3("fogColor", glm::vec3(0.12f, 0.12f, 0.14f));
-        solidShader.setFloat("fogDensity", 0.03f);
-
-
-        glBindVertexArray(cubeVAO);
-
-        auto drawBlock = [&](glm::vec3 pos, glm::vec3 scale, glm::vec3 col) {
-            glm::mat4 M(1.0f);
-            M = glm::translate(M, pos);
-            M = glm::scale(M, scale);
-            solidShader.setMat4("model", M);
-            solidShader.setVec3("objectColor", col);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
-            };
-
-        // room
-        drawBlock(floorPos, floorScale, floorCol);
-        drawBlock(ceilPos, ceilScale, ceilCol);
-        drawBlock(backPos, backScale, backCol);
-        drawBlock(frontPos, frontScale, frontCol);
-        drawBlock(leftPos, leftScale, sideCol);
-        drawBlock(rightPos, rightScale, sideCol);
-
-        // furniture
-        drawCoffeeTable(ctx, glm::vec3(0.8f, 0.0f, -1.2f), 0.0f, glm::vec3(1.0f));
-        drawTVStand(ctx, glm::vec3(0.0f, 0.50f, -4.70f));
-        drawSofa(ctx, glm::vec3(3.0f, 0.0f, -1.2f), 270.0f);
-
-        // draw a tiny lamp cube at lightPos so you can see it
         {
-            glm::mat4 M(1.0f);
-            M = glm::translate(M, lightPos);
-            M = glm::scale(M, glm::vec3(0.12f));
-            solidShader.setMat4("model", M);
-            solidShader.setVec3("objectColor", hexColor(0xFFF2B2)); // pale yellow
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+            GpuProfiler::Scope pass(&profiler, "swap");
+            PROFILE_SCOPE("glfwSwapBuffers");
+            glfwSwapBuffers(window);
         }
-
-        glfwSwapBuffers(window);
+        profiler.endFrame();
         glfwPollEvents();
+
+        if (showProfiler && now - lastTitle > 0.5f) {
+            // GL state calls of the last frame: passed on / dropped by GLState
+            char state[96];
+            std::snprintf(state, sizeof(state), " | gl state %llu set, %llu skipped | textures %d loading",
+                (unsigned long long)renderStats().stateCalls, (unsigned long long)renderStats().stateSkipped,
+                renderer.textures.pending());
+            glfwSetWindowTitle(window, (profiler.summary() + state).c_str());
+            lastTitle = now;
+        }
+    }
+
+    if (!profileOut.empty()) {
+        std::ofstream out(profileOut);
+        bool json = profileOut.size() >= 5 && profileOut.compare(profileOut.size() - 5, 5, ".json") == 0;
+        if (json) profiler.writeJson(out);
+        else profiler.writeCsv(out);
+    }
+    if (!traceOut.empty()) {
+        std::ofstream out(traceOut);
+        CpuProfiler::writeChromeTrace(out);
     }
 
-    glDeleteVertexArrays(1, &cubeVAO);
-    glDeleteBuffers(1, &cubeVBO);
-    glfwTerminate();
     return 0;
 }
@@ -2,16 +2,37 @@
 layout(location=0) in vec3 aPos;
 layout(location=1) in vec3 aNormal;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// per-instance (BoxBatch): model takes locations 2..5, normalMatrix 6..8
+layout(location=2) in mat4 model;
+layout(location=6) in mat3 normalMatrix;   // inverse-transpose, built on the CPU
+layout(location=9) in vec3 color;
+layout(location=10) in vec4 uvTransform;   // xy scale (repeats per meter), zw offset
+layout(location=11) in float layer;        // in the material array, -1 = untextured
+
+#include "frame_uniforms.glsl"
 
 out vec3 FragPos;   // world-space
 out vec3 Normal;    // world-space
+out vec3 objectColor;
+out vec2 vUV;
+flat out float vLayer;
+
+// must match depth.vert bit for bit (GL_EQUAL after the depth pre-pass)
+invariant gl_Position;
 
 void main() {
     vec4 worldPos = model * vec4(aPos, 1.0);
     FragPos = worldPos.xyz;
-    Normal  = mat3(transpose(inverse(model))) * aNormal;
+    Normal  = normalMatrix * aNormal;
+    objectColor = color;
+
+    // box-mapped UVs: position on the face in meters (the model's scale
+    // undone), so every piece of a material shows the same texel density
+    vec3 size = vec3(length(model[0].xyz), length(model[1].xyz), length(model[2].xyz));
+    vec3 p = (aPos + 0.5) * size;
+    vec3 n = abs(aNormal);
+    vec2 uv = n.x > 0.5 ? p.zy : (n.y > 0.5 ? p.xz : p.xy);
+    vUV = uv * uvTransform.xy + uvTransform.zw;
+    vLayer = layer;
     gl_Position = projection * view * worldPos;
 }
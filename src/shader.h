@@ -8,85 +8,356 @@
 #include <string>
 #include <fstream>
 #include <sstream>
+#include <stdexcept>
 #include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
 
+#include "GLExt.h"
+#include "GLState.h"
+#include "RenderStats.h"
+#include "ShaderCache.h"
+#include "ShaderCompiler.h"
+
+// FNV-1a over a uniform name. constexpr so string literals hash at compile time.
+constexpr uint32_t uniformHash(const char* s, size_t n) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; ++i) {
+        h ^= (uint32_t)(unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Handle used by the set* functions. Built implicitly from a literal
+// ("model") or a std::string; hot-path calls never construct a string.
+// It only points at the name, so it is meant to be built in the call that
+// uses it: the std::string overload refuses temporaries, which would be
+// gone before a stored handle is used.
+struct UniformName {
+    uint32_t hash;
+    const char* str;
+
+    template <size_t N>
+    constexpr UniformName(const char (&s)[N]) : hash(uniformHash(s, N - 1)), str(s) {}
+    UniformName(const std::string& s) : hash(uniformHash(s.c_str(), s.size())), str(s.c_str()) {}
+    UniformName(std::string&&) = delete;
+};
+
+// binding point of the per-frame "FrameUniforms" block (FrameUniforms.h);
+// every program that declares the block is hooked up to it at link time
+const GLuint kFrameUniformsBinding = 0;
+
+// GLSL of one program, read from its files (Shader::load)
+struct ShaderSource {
+    std::string vertex, fragment;
+    std::vector<std::string> includes;   // file names pasted in by #include
+};
+
+// A vertex + fragment program. Linked programs come from the ShaderCache
+// when it is open, else they are compiled from source. wait = false leaves
+// the compile / link running until finish(): on driver threads with
+// KHR_parallel_shader_compile, else on `compiler`'s thread when one is
+// given; constructing several programs that way, then finishing them,
+// overlaps their compiles. Without either, the work happens in finish().
+// The program is not deleted with the object (it is swapped around on
+// reload); cancel() or glState().deleteProgram(ID) it.
 class Shader {
 public:
     unsigned int ID;
+    std::vector<std::string> includes;   // as in ShaderSource, for hot reload
+
+    Shader(const char* vertexPath, const char* fragmentPath, bool wait = true, ShaderCompiler* compiler = nullptr)
+        : Shader(load(vertexPath, fragmentPath), wait, compiler) {}
+
+    explicit Shader(const ShaderSource& src, bool wait = true, ShaderCompiler* compiler = nullptr)
+        : includes(src.includes) {
+        ID = glCreateProgram();
+        ShaderCache& cache = shaderCache();
+        if (cache.enabled()) {
+            cacheKey = cache.key(src.vertex, src.fragment);
+            if (cache.load(ID, cacheKey)) {
+                linkOk = true;
+                linked();
+                return;
+            }
+        }
+
+        if (!wait && compiler && compiler->running() && !GLExt::parallelShaderCompile) {
+            // the worker makes its own program; this one only tried the cache
+            glState().deleteProgram(ID);
+            ID = 0;
+            worker = compiler;
+            job = compiler->submit(src.vertex, src.fragment, cache.enabled());
+            pending = true;
+            return;
+        }
 
-    Shader(const char* vertexPath, const char* fragmentPath) {
-        // 1) read files
-        std::string vCode, fCode;
-        std::ifstream vFile, fFile;
-        vFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        fFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        // errors are read in finish(), which is what waits
+        startBuild(ID, src.vertex, src.fragment, cache.enabled(), vertex, fragment);
+        pending = true;
+
+        if (wait) finish();
+    }
+
+    // 1) read files. A line `#include "name"` is replaced by that file,
+    // looked up next to the shader (one level: included files are pasted
+    // as they are), so blocks every program shares live in one .glsl.
+    static ShaderSource load(const char* vertexPath, const char* fragmentPath) {
+        ShaderSource src;
         try {
-            vFile.open(vertexPath);
-            fFile.open(fragmentPath);
-            std::stringstream vStream, fStream;
-            vStream << vFile.rdbuf();
-            fStream << fFile.rdbuf();
-            vFile.close();
-            fFile.close();
-            vCode = vStream.str();
-            fCode = fStream.str();
+            src.vertex = readFile(vertexPath);
+            src.fragment = readFile(fragmentPath);
+            expandIncludes(src.vertex, vertexPath, src.includes);
+            expandIncludes(src.fragment, fragmentPath, src.includes);
         }
         catch (...) {
             std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ\n";
         }
+        return src;
+    }
 
-        const char* vShaderCode = vCode.c_str();
-        const char* fShaderCode = fCode.c_str();
+    // false while the driver or the ShaderCompiler thread is still
+    // compiling / linking (without either, finish() is where it happens)
+    bool ready() const {
+        if (!pending) return true;
+        if (worker) return worker->done(job);
+        if (!GLExt::parallelShaderCompile) return true;
+        GLint done = GL_FALSE;
+        glGetProgramiv(ID, GL_COMPLETION_STATUS_KHR, &done);
+        return done == GL_TRUE;
+    }
 
-        // 2) compile
-        unsigned int vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, nullptr);
-        glCompileShader(vertex);
-        checkCompileErrors(vertex, "VERTEX");
+    // wait for the link, report errors, store it in the cache; a no-op
+    // once done. Returns valid()
+    bool finish() {
+        if (!pending) return linkOk;
+        pending = false;
+        if (worker) {
+            ID = worker->wait(job, linkOk);
+            worker = nullptr;
+        }
+        else {
+            linkOk = endBuild(ID, vertex, fragment);
+            vertex = fragment = 0;
+        }
 
-        unsigned int fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, nullptr);
-        glCompileShader(fragment);
-        checkCompileErrors(fragment, "FRAGMENT");
+        if (linkOk && shaderCache().enabled()) shaderCache().store(ID, cacheKey);
+        linked();
+        return linkOk;
+    }
 
-        // 3) link
-        ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
-        glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
+    // a program that will not be used after all, finished or not: a build
+    // still running is dropped with its shader objects, then the program
+    void cancel() {
+        if (pending && worker) worker->cancel(job);
+        else if (pending) {
+            glDeleteShader(vertex);   // attached, so they go with the program
+            glDeleteShader(fragment);
+        }
+        pending = false;
+        worker = nullptr;
+        vertex = fragment = 0;
+        if (ID) glState().deleteProgram(ID);
+        ID = 0;
+    }
 
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
+    // compile and link into `program` now, errors to std::cerr; what the
+    // ShaderCompiler thread runs, so raw GL only (GLState belongs to the
+    // render thread)
+    static bool build(GLuint program, const std::string& vertexSrc, const std::string& fragmentSrc, bool retrievable) {
+        GLuint vs = 0, fs = 0;
+        startBuild(program, vertexSrc, fragmentSrc, retrievable, vs, fs);
+        return endBuild(program, vs, fs);
     }
 
-    void use() const { glUseProgram(ID); }
+    // linked without errors (after finish())
+    bool valid() const { return linkOk; }
+
+    void use() const { glState().useProgram(ID); }
+
+    // cached location (-1 if the uniform is not active; glUniform* ignores -1).
+    // The hash finds the entry, the name confirms it: an inactive uniform
+    // that happens to share an active one's hash must not write that one
+    GLint location(UniformName name) const {
+        auto it = locations.find(name.hash);
+        if (it == locations.end() || std::strcmp(it->second.name.c_str(), name.str) != 0) return -1;
+        return it->second.loc;
+    }
 
-    void setFloat(const std::string& name, float v) const {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), v);
+    void setFloat(UniformName name, float v) const {
+        ++renderStats().uniformUploads;
+        glUniform1f(location(name), v);
     }
    
 
 
     // uniforms
-    void setMat4(const std::string& name, const glm::mat4& mat) const {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+    void setMat4(UniformName name, const glm::mat4& mat) const {
+        ++renderStats().uniformUploads;
+        glUniformMatrix4fv(location(name), 1, GL_FALSE, glm::value_ptr(mat));
     }
-    void setVec3(const std::string& name, const glm::vec3& v) const {
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(v));
+    void setMat3(UniformName name, const glm::mat3& mat) const {
+        ++renderStats().uniformUploads;
+        glUniformMatrix3fv(location(name), 1, GL_FALSE, glm::value_ptr(mat));
     }
-    void setVec2(const std::string& name, const glm::vec2& v) const {
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(v));
+    void setVec3(UniformName name, const glm::vec3& v) const {
+        ++renderStats().uniformUploads;
+        glUniform3fv(location(name), 1, glm::value_ptr(v));
     }
-    void setInt(const std::string& name, int value) const {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+    void setVec2(UniformName name, const glm::vec2& v) const {
+        ++renderStats().uniformUploads;
+        glUniform2fv(location(name), 1, glm::value_ptr(v));
     }
-    void setBool(const std::string& name, bool value) const {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value ? 1 : 0);
+    void setInt(UniformName name, int value) const {
+        ++renderStats().uniformUploads;
+        glUniform1i(location(name), value);
+    }
+    void setBool(UniformName name, bool value) const {
+        ++renderStats().uniformUploads;
+        glUniform1i(location(name), value ? 1 : 0);
     }
 
 private:
-    static void checkCompileErrors(unsigned int obj, const std::string& type) {
+    // compile both stages and start the link; nothing here waits
+    static void startBuild(GLuint program, const std::string& vertexSrc, const std::string& fragmentSrc,
+                           bool retrievable, GLuint& vs, GLuint& fs) {
+        const char* vShaderCode = vertexSrc.c_str();
+        const char* fShaderCode = fragmentSrc.c_str();
+
+        vs = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(vs, 1, &vShaderCode, nullptr);
+        glCompileShader(vs);
+
+        fs = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(fs, 1, &fShaderCode, nullptr);
+        glCompileShader(fs);
+
+        glAttachShader(program, vs);
+        glAttachShader(program, fs);
+        if (retrievable) ShaderCache::markRetrievable(program);
+        glLinkProgram(program);
+    }
+
+    // the status queries wait for the driver; the stages are freed after
+    static bool endBuild(GLuint program, GLuint vs, GLuint fs) {
+        checkCompileErrors(vs, "VERTEX");
+        checkCompileErrors(fs, "FRAGMENT");
+        const bool ok = checkCompileErrors(program, "PROGRAM");
+        glDetachShader(program, vs);
+        glDetachShader(program, fs);
+        glDeleteShader(vs);
+        glDeleteShader(fs);
+        return ok;
+    }
+
+    static std::string readFile(const std::string& path) {
+        std::ifstream file;
+        file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        file.open(path);
+        std::stringstream stream;
+        stream << file.rdbuf();
+        return stream.str();
+    }
+
+    static void expandIncludes(std::string& text, const std::string& path, std::vector<std::string>& includes) {
+        const size_t slash = path.find_last_of("/\\");
+        const std::string dir = slash == std::string::npos ? "" : path.substr(0, slash + 1);
+        std::string out;
+        size_t pos = 0;
+        while (pos < text.size()) {
+            size_t end = text.find('\n', pos);
+            end = end == std::string::npos ? text.size() : end + 1;
+            const std::string line = text.substr(pos, end - pos);
+            pos = end;
+            const size_t start = line.find_first_not_of(" \t");
+            if (start == std::string::npos || line.compare(start, 8, "#include") != 0) {
+                out += line;
+                continue;
+            }
+            const size_t open = line.find('"', start + 8);
+            const size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+            if (close == std::string::npos) {
+                std::cerr << "ERROR::SHADER::BAD_INCLUDE " << path << ": " << line;
+                throw std::runtime_error("bad include");
+            }
+            const std::string name = line.substr(open + 1, close - open - 1);
+            out += readFile(dir + name);
+            if (!out.empty() && out.back() != '\n') out += '\n';
+            bool seen = false;
+            for (const std::string& n : includes) seen = seen || n == name;
+            if (!seen) includes.push_back(name);
+        }
+        text.swap(out);
+    }
+
+    // name hash -> location (and the name, to rule out collisions), filled
+    // once after linking
+    struct Location {
+        GLint loc;
+        std::string name;
+    };
+    std::unordered_map<uint32_t, Location> locations;
+
+    unsigned int vertex = 0, fragment = 0;   // until finish()
+    ShaderCompiler* worker = nullptr;        // building on its thread, until finish()
+    uint64_t job = 0;
+    bool pending = false;
+    bool linkOk = false;
+    uint64_t cacheKey = 0;
+
+    // program state a binary does not carry
+    void linked() {
+        reflectUniforms();
+
+        GLuint block = glGetUniformBlockIndex(ID, "FrameUniforms");
+        if (block != GL_INVALID_INDEX)
+            glUniformBlockBinding(ID, block, kFrameUniformsBinding);
+    }
+
+    void addLocation(const std::string& name, GLint loc) {
+        uint32_t h = uniformHash(name.c_str(), name.size());
+        auto res = locations.emplace(h, Location{ loc, name });
+        // two active names on one hash: the second is unreachable
+        if (!res.second && res.first->second.name != name)
+            std::cerr << "WARNING::SHADER::UNIFORM_HASH_COLLISION: " << name << " / " << res.first->second.name << "\n";
+    }
+
+    // reflect every active uniform once so the set* calls never hit the driver
+    void reflectUniforms() {
+        locations.clear();
+
+        GLint count = 0, maxLen = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLen);
+        std::vector<char> buf((size_t)maxLen + 1);
+
+        for (GLint i = 0; i < count; ++i) {
+            GLsizei len = 0; GLint size = 0; GLenum type = 0;
+            glGetActiveUniform(ID, (GLuint)i, (GLsizei)buf.size(), &len, &size, &type, buf.data());
+            std::string name(buf.data(), (size_t)len);
+
+            GLint loc = glGetUniformLocation(ID, name.c_str());
+            if (loc < 0) continue; // member of a uniform block
+
+            addLocation(name, loc);
+
+            // arrays come back as "name[0]": also register "name" and every element
+            size_t bracket = name.rfind("[0]");
+            if (bracket != std::string::npos && bracket + 3 == name.size()) {
+                std::string base = name.substr(0, bracket);
+                addLocation(base, loc);
+                for (GLint e = 1; e < size; ++e) {
+                    std::string elem = base + "[" + std::to_string(e) + "]";
+                    addLocation(elem, glGetUniformLocation(ID, elem.c_str()));
+                }
+            }
+        }
+    }
+
+    static bool checkCompileErrors(unsigned int obj, const std::string& type) {
         int success; char infoLog[1024];
         if (type != "PROGRAM") {
             glGetShaderiv(obj, GL_COMPILE_STATUS, &success);
@@ -102,6 +373,7 @@ private:
                 std::cerr << "ERROR::PROGRAM_LINKING_ERROR\n" << infoLog << "\n";
             }
         }
+        return success != 0;
     }
 };
 
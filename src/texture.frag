@@ -1,9 +1,10 @@
 #version 330 core
 in vec2 vUV;
+flat in float vLayer;
 out vec4 FragColor;
 
-uniform sampler2D material_diffuse;
+uniform sampler2DArray materials;   // TextureArray.h
 
 void main() {
-    FragColor = texture(material_diffuse, vUV);
+    FragColor = texture(materials, vec3(vUV, vLayer));
 }
@@ -1,15 +1,24 @@
 #version 330 core
+// unlit textured boxes: the BoxBatch instance layout of room.vert, with the
+// per-instance material (uv scale + offset, array layer) and nothing else
 layout (location=0) in vec3 aPos;
-layout (location=2) in vec2 aTex;
+layout (location=1) in vec3 aNormal;
+layout (location=2) in mat4 model;
+layout (location=10) in vec4 uvTransform;   // xy scale (repeats per meter), zw offset
+layout (location=11) in float layer;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-uniform vec2 uvScale = vec2(1.0);
+#include "frame_uniforms.glsl"
 
 out vec2 vUV;
+flat out float vLayer;
 
 void main() {
-    vUV = aTex * uvScale;
+    // same box mapping as room.vert
+    vec3 size = vec3(length(model[0].xyz), length(model[1].xyz), length(model[2].xyz));
+    vec3 p = (aPos + 0.5) * size;
+    vec3 n = abs(aNormal);
+    vec2 uv = n.x > 0.5 ? p.zy : (n.y > 0.5 ? p.xz : p.xy);
+    vUV = uv * uvTransform.xy + uvTransform.zw;
+    vLayer = max(layer, 0.0);
     gl_Position = projection * view * model * vec4(aPos, 1.0);
-}
\ No newline at end of file
+}
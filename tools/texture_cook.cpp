@@ -0,0 +1,132 @@
+// Cooks source images into GPU-ready .rtex files (src/TextureFile.h): decode
+// with stb_image, flip for GL, halve down to --max-size, build the whole
+// mip chain with a box filter and block-compress every level, block rows
+// spread over all cores. TextureLoader picks up a cooked file next to its
+// source (textures/wall.jpg -> textures/wall.rtex) and uploads it straight
+// from the map, without decoding or glGenerateMipmap.
+//
+// usage: texture_cook [--format auto|bc1|bc3|rgba8] [--max-size 2048]
+//                     [-o out.rtex] in.jpg [more.png ...]
+//   auto: bc3 if any texel is not opaque, else bc1
+
+#include "TextureFile.h"
+#include "WorkerPool.h"
+#include "stb_image.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// RMS error over RGBA of a level against what the GPU will sample
+double levelRmse(const std::vector<uint8_t>& source, const TextureLevelData& level, TextureFormat format) {
+    std::vector<uint8_t> decoded;
+    decodeTextureLevel(format, level.data.data(), level.width, level.height, decoded);
+    double sum = 0.0;
+    for (size_t i = 0; i < source.size(); ++i) {
+        const double d = (double)source[i] - decoded[i];
+        sum += d * d;
+    }
+    return source.empty() ? 0.0 : std::sqrt(sum / source.size());
+}
+
+bool cook(const std::string& in, const std::string& out, const std::string& formatArg, int maxSize, WorkerPool& pool) {
+    const auto start = std::chrono::steady_clock::now();
+    int w = 0, h = 0, channels = 0;
+    stbi_uc* data = stbi_load(in.c_str(), &w, &h, &channels, 4);
+    if (!data) {
+        std::cerr << in << ": " << stbi_failure_reason() << "\n";
+        return false;
+    }
+    const int sourceW = w, sourceH = h;
+    // GL's first row is the bottom one
+    const size_t rowBytes = (size_t)w * 4;
+    std::vector<uint8_t> pixels(rowBytes * h);
+    for (int y = 0; y < h; ++y)
+        std::memcpy(&pixels[(size_t)(h - 1 - y) * rowBytes], data + (size_t)y * rowBytes, rowBytes);
+    stbi_image_free(data);
+    while (maxSize > 0 && std::max(w, h) > maxSize) halveImage(pixels, w, h);
+
+    TextureFormat format = TextureFormat::BC1;
+    if (formatArg == "bc3") format = TextureFormat::BC3;
+    else if (formatArg == "rgba8") format = TextureFormat::RGBA8;
+    else if (formatArg == "auto") {
+        for (size_t i = 3; i < pixels.size(); i += 4)
+            if (pixels[i] != 255) { format = TextureFormat::BC3; break; }
+    }
+
+    std::vector<TextureLevelData> levels;
+    double rmse = 0.0;
+    for (;;) {
+        TextureLevelData level{ w, h, std::vector<uint8_t>(textureLevelBytes(format, w, h)) };
+        if (format == TextureFormat::RGBA8) {
+            level.data = pixels;
+        } else {
+            const int blockRows = std::max(1, (h + 3) / 4);
+            const size_t blockRowBytes = (size_t)std::max(1, (w + 3) / 4) * textureBlockBytes(format);
+            pool.forEach(blockRows, [&](int row) {
+                encodeBlockRow(format, pixels.data(), w, h, row, level.data.data() + row * blockRowBytes);
+            });
+        }
+        if (levels.empty()) rmse = levelRmse(pixels, level, format);
+        levels.push_back(std::move(level));
+        if (w == 1 && h == 1) break;
+        halveImage(pixels, w, h);
+    }
+
+    if (!saveTextureBinary(out, format, levels)) {
+        std::cerr << "cannot write " << out << "\n";
+        return false;
+    }
+    size_t bytes = 0;
+    for (const TextureLevelData& l : levels) bytes += l.data.size();
+    std::printf("%s: %dx%d -> %dx%d %s, %zu levels, %.1f KB (rgba8 + mips %.1f KB), rmse %.2f, %.0f ms\n",
+        out.c_str(), sourceW, sourceH, levels[0].width, levels[0].height, textureFormatName(format),
+        levels.size(), bytes / 1024.0, levels[0].width * levels[0].height * 4 * 4.0 / 3.0 / 1024.0,
+        rmse, msSince(start));
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string format = "auto", outPath;
+    int maxSize = 2048;
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        bool more = i + 1 < argc;
+        if (a == "--format" && more) format = argv[++i];
+        else if (a == "--max-size" && more) maxSize = std::atoi(argv[++i]);
+        else if (a == "-o" && more) outPath = argv[++i];
+        else if (!a.empty() && a[0] == '-') { std::cerr << "unknown argument " << a << "\n"; return 1; }
+        else inputs.push_back(a);
+    }
+    if (inputs.empty() || (!outPath.empty() && inputs.size() > 1) ||
+        (format != "auto" && format != "bc1" && format != "bc3" && format != "rgba8")) {
+        std::cerr << "usage: texture_cook [--format auto|bc1|bc3|rgba8] [--max-size 2048] [-o out.rtex] in.jpg [more ...]\n";
+        return 1;
+    }
+
+    WorkerPool pool;
+    bool ok = true;
+    for (const std::string& in : inputs) {
+        std::string out = outPath;
+        if (out.empty()) {
+            const size_t slash = in.find_last_of("/\\"), dot = in.find_last_of('.');
+            out = (dot == std::string::npos || (slash != std::string::npos && dot < slash) ? in : in.substr(0, dot)) + ".rtex";
+        }
+        ok = cook(in, out, format, maxSize, pool) && ok;
+    }
+    return ok ? 0 : 1;
+}